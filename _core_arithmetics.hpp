@@ -12,6 +12,8 @@
 #define _asm_add asm_add
 #define _asm_sub asm_sub
 #define _asm_mul asm_mul
+#define _asm_sqr asm_sqr
+#define _asm_submul_1 asm_submul_1
 #define _asm_short_add asm_short_add
 #define _asm_short_sub asm_short_sub
 #endif
@@ -21,16 +23,87 @@ namespace _core {
         uint64_t _asm_add(uint64_t *, uint64_t const *, size_t);
         uint64_t _asm_sub(uint64_t *, uint64_t const *, size_t);
         uint64_t _asm_mul(uint64_t *, uint64_t const *, uint64_t const *, size_t, size_t);
+        uint64_t _asm_sqr(uint64_t *, uint64_t const *, size_t);
+        uint64_t _asm_submul_1(uint64_t *, uint64_t const *, size_t, uint64_t);
         uint64_t _asm_short_add(uint64_t *, uint64_t, size_t);
         uint64_t _asm_short_sub(uint64_t *, uint64_t, size_t);
     }
 
     const __uint128_t t64 = __uint128_t(1) << 64;
     
-    void set_constant_divisor(uint64_t d);
-    uint64_t divd(__uint128_t n, uint64_t d, uint64_t& rm);
-    uint64_t _pow10(size_t);
-    uint64_t _fast_short_div(uint64_t *, uint64_t, size_t);
+    /*
+     * divisor with its precomputed reciprocal (division by invariant
+     * integers), an immutable value: build once, share between threads
+     * */
+    struct precomputed_divisor {
+        uint64_t d;
+        uint64_t l;
+        uint64_t d_normal;
+        uint64_t msl;
+
+        // divides by 1
+        precomputed_divisor() : precomputed_divisor(1) {}
+        explicit precomputed_divisor(uint64_t d);
+    };
+
+    uint64_t divd(__uint128_t n, precomputed_divisor const& d, uint64_t& rm);
+
+    // the largest power of a base that fits a limb
+    struct radix_chunk {
+        uint64_t power;
+        size_t digits;
+    };
+
+    /*
+     * built at compile time: pow[b][e] = b^e for e up to the chunk
+     * of b, chunk[b] is that chunk, for every base 2 to 36
+     * */
+    struct radix_table {
+        uint64_t pow[37][64];
+        radix_chunk chunk[37];
+
+        constexpr radix_table() : pow{}, chunk{} {
+            for (unsigned b = 2; b <= 36; ++b) {
+                size_t e = 0;
+                pow[b][0] = 1;
+                for (; pow[b][e] <= UINT64_MAX / b; ++e) {
+                    pow[b][e + 1] = pow[b][e] * b;
+                }
+                chunk[b] = {pow[b][e], e};
+            }
+        }
+    };
+
+    inline constexpr radix_table _radix_table{};
+
+    constexpr uint64_t _small_pow(unsigned base, size_t e) {
+        return _radix_table.pow[base][e];
+    }
+
+    constexpr uint64_t _pow10(size_t i) {
+        return _radix_table.pow[10][i];
+    }
+
+    constexpr radix_chunk _radix_chunk(unsigned base) {
+        return _radix_table.chunk[base];
+    }
+
+    static_assert(_pow10(19) == 10000000000000000000ULL && _radix_chunk(10).digits == 19);
+    static_assert(_radix_chunk(2).digits == 63 && _radix_chunk(36).digits == 12);
+    uint64_t _fast_short_div(uint64_t *, precomputed_divisor const&, size_t);
+
+    // value of up to 19 decimal characters, false if one of them is not a digit
+    bool _parse_digits(char const *, size_t, uint64_t &);
+    bool _all_digits(char const *, size_t);
+
+    // the same for any base up to 36, one radix chunk at most
+    extern const char _digit_chars[];
+    unsigned _digit_value(char);
+    bool _parse_digits(char const *, size_t, unsigned, uint64_t &);
+    bool _all_digits(char const *, size_t, unsigned);
+
+    // res[0, na + nb) = a * b, number-theoretic transform, a == b squares
+    void _ntt_mul(uint64_t *, uint64_t const *, size_t, uint64_t const *, size_t);
 }
 
 #endif /* _core_arithmetics.hpp */
@@ -0,0 +1,211 @@
+/*
+    author dzhiblavi
+ */
+
+#include <cstring>
+#include <_core_arithmetics.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _CORE_DIGITS_X86
+#endif
+
+/*
+ * decimal digit chunks: validation and conversion by 8 (SWAR),
+ * 16 (SSE4.1) and 32 (AVX2, validation only) characters at a time,
+ * the vector variants are picked once at runtime
+ * */
+namespace _core {
+    namespace {
+        const uint64_t ZEROS = 0x3030303030303030ULL;
+
+        bool scalar_digits(char const *s, size_t len, uint64_t &out) {
+            for (size_t i = 0; i < len; ++i) {
+                unsigned c = (unsigned char) s[i] - '0';
+                if (c > 9) {
+                    return false;
+                }
+                out = out * 10 + c;
+            }
+            return true;
+        }
+
+        // the first character is the lowest byte of v
+        bool swar_valid_8(uint64_t v) {
+            uint64_t hi = v & 0xf0f0f0f0f0f0f0f0ULL;
+            uint64_t hi6 = (v + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL;
+            return (hi | hi6 >> 4) == 0x3333333333333333ULL;
+        }
+
+        uint64_t swar_convert_8(uint64_t v) {
+            v -= ZEROS;
+            v = v * 10 + (v >> 8);
+            v = ((v & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))
+                 + ((v >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32))) >> 32;
+            return v;
+        }
+
+        bool swar_digits(char const *s, size_t len, uint64_t &out) {
+            out = 0;
+            size_t head = len % 8;
+            if (!scalar_digits(s, head, out)) {
+                return false;
+            }
+            for (size_t i = head; i < len; i += 8) {
+                uint64_t v;
+                memcpy(&v, s + i, 8);
+                if (!swar_valid_8(v)) {
+                    return false;
+                }
+                out = out * 100000000 + swar_convert_8(v);
+            }
+            return true;
+        }
+
+        bool swar_all_digits(char const *s, size_t len) {
+            size_t i = 0;
+            for (; i + 8 <= len; i += 8) {
+                uint64_t v;
+                memcpy(&v, s + i, 8);
+                if (!swar_valid_8(v)) {
+                    return false;
+                }
+            }
+            uint64_t rest = 0;
+            return scalar_digits(s + i, len - i, rest);
+        }
+
+#ifdef _CORE_DIGITS_X86
+        __attribute__((target("sse4.1")))
+        bool sse_valid_16(__m128i v) {
+            __m128i nine = _mm_set1_epi8(9);
+            __m128i ok = _mm_cmpeq_epi8(_mm_max_epu8(v, nine), nine);
+            return _mm_movemask_epi8(ok) == 0xffff;
+        }
+
+        __attribute__((target("sse4.1")))
+        bool sse_digits(char const *s, size_t len, uint64_t &out) {
+            if (len < 16) {
+                return swar_digits(s, len, out);
+            }
+            out = 0;
+            if (!scalar_digits(s, len - 16, out)) {
+                return false;
+            }
+            __m128i v = _mm_loadu_si128((__m128i const *) (s + len - 16));
+            v = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+            if (!sse_valid_16(v)) {
+                return false;
+            }
+            v = _mm_maddubs_epi16(v, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+            v = _mm_madd_epi16(v, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+            v = _mm_packus_epi32(v, v);
+            v = _mm_madd_epi16(v, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+            uint64_t hi = (uint32_t) _mm_cvtsi128_si32(v);
+            uint64_t lo = (uint32_t) _mm_extract_epi32(v, 1);
+            out = out * 10000000000000000ULL + hi * 100000000 + lo;
+            return true;
+        }
+
+        __attribute__((target("sse4.1")))
+        bool sse_all_digits(char const *s, size_t len) {
+            size_t i = 0;
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128((__m128i const *) (s + i));
+                if (!sse_valid_16(_mm_sub_epi8(v, _mm_set1_epi8('0')))) {
+                    return false;
+                }
+            }
+            return swar_all_digits(s + i, len - i);
+        }
+
+        __attribute__((target("avx2")))
+        bool avx2_all_digits(char const *s, size_t len) {
+            __m256i zero = _mm256_set1_epi8('0'), nine = _mm256_set1_epi8(9);
+            size_t i = 0;
+            for (; i + 32 <= len; i += 32) {
+                __m256i v = _mm256_sub_epi8(_mm256_loadu_si256((__m256i const *) (s + i)), zero);
+                __m256i ok = _mm256_cmpeq_epi8(_mm256_max_epu8(v, nine), nine);
+                if (_mm256_movemask_epi8(ok) != -1) {
+                    return false;
+                }
+            }
+            return swar_all_digits(s + i, len - i);
+        }
+#endif
+
+        using digits_fn = bool (*)(char const *, size_t, uint64_t &);
+        using all_digits_fn = bool (*)(char const *, size_t);
+
+        digits_fn select_digits() {
+#ifdef _CORE_DIGITS_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse4.1")) {
+                return sse_digits;
+            }
+#endif
+            return swar_digits;
+        }
+
+        all_digits_fn select_all_digits() {
+#ifdef _CORE_DIGITS_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return avx2_all_digits;
+            }
+            if (__builtin_cpu_supports("sse4.1")) {
+                return sse_all_digits;
+            }
+#endif
+            return swar_all_digits;
+        }
+    }
+
+    bool _parse_digits(char const *s, size_t len, uint64_t &out) {
+        static const digits_fn impl = select_digits();
+        return impl(s, len, out);
+    }
+
+    bool _all_digits(char const *s, size_t len) {
+        static const all_digits_fn impl = select_all_digits();
+        return impl(s, len);
+    }
+
+    const char _digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    unsigned _digit_value(char c) {
+        unsigned u = (unsigned char) c;
+        if (u - '0' < 10) {
+            return u - '0';
+        }
+        u |= 0x20;
+        return u - 'a' < 26 ? u - 'a' + 10 : 36;
+    }
+
+    bool _parse_digits(char const *s, size_t len, unsigned base, uint64_t &out) {
+        if (base == 10) {
+            return _parse_digits(s, len, out);
+        }
+        out = 0;
+        for (size_t i = 0; i < len; ++i) {
+            unsigned v = _digit_value(s[i]);
+            if (v >= base) {
+                return false;
+            }
+            out = out * base + v;
+        }
+        return true;
+    }
+
+    bool _all_digits(char const *s, size_t len, unsigned base) {
+        if (base == 10) {
+            return _all_digits(s, len);
+        }
+        for (size_t i = 0; i < len; ++i) {
+            if (_digit_value(s[i]) >= base) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,220 @@
+/*
+    author dzhiblavi
+ */
+
+#include <cassert>
+#include <cstring>
+#include <vector.hpp>
+#include <_core_arithmetics.hpp>
+
+/*
+ * three-prime number-theoretic transform multiplication
+ * limbs are transformed as they are (full 64 bits), convolution terms
+ * are bounded by N * 2^128 < p1 * p2 * p3 ~ 2^186 and restored by CRT
+ * */
+namespace _core {
+    namespace {
+        constexpr uint64_t mulmod(uint64_t a, uint64_t b, uint64_t p) {
+            return (uint64_t) ((__uint128_t) a * b % p);
+        }
+
+        constexpr uint64_t powmod(uint64_t a, uint64_t e, uint64_t p) {
+            uint64_t r = 1;
+            for (; e; e >>= 1, a = mulmod(a, a, p)) {
+                if (e & 1) {
+                    r = mulmod(r, a, p);
+                }
+            }
+            return r;
+        }
+
+        /*
+         * montgomery arithmetic modulo p < 2^62, R = 2^64
+         * */
+        struct ntt_prime {
+            uint64_t p;
+            uint64_t g;
+            uint64_t ninv; // -p^(-1) mod R
+            uint64_t r1;   // R mod p
+            uint64_t r2;   // R^2 mod p
+
+            constexpr ntt_prime(uint64_t p_, uint64_t g_)
+                    : p(p_), g(g_), ninv(0), r1(0), r2(0) {
+                uint64_t inv = p;
+                for (int i = 0; i < 6; ++i) {
+                    inv *= 2 - p * inv;
+                }
+                ninv = -inv;
+                r1 = (uint64_t) (t64 % p);
+                r2 = mulmod(r1, r1, p);
+            }
+
+            uint64_t redc(__uint128_t t) const {
+                uint64_t m = (uint64_t) t * ninv;
+                uint64_t r = (uint64_t) ((t + (__uint128_t) m * p) >> 64);
+                return r >= p ? r - p : r;
+            }
+
+            uint64_t mul(uint64_t a, uint64_t b) const {
+                return redc((__uint128_t) a * b);
+            }
+
+            uint64_t add(uint64_t a, uint64_t b) const {
+                uint64_t r = a + b;
+                return r >= p ? r - p : r;
+            }
+
+            uint64_t sub(uint64_t a, uint64_t b) const {
+                return a >= b ? a - b : a + p - b;
+            }
+
+            uint64_t to_mont(uint64_t a) const {
+                return mul(a % p, r2);
+            }
+        };
+
+        constexpr ntt_prime P1(0x3fffc00000000001ULL, 11);
+        constexpr ntt_prime P2(0x3fffbe0000000001ULL, 3);
+        constexpr ntt_prime P3(0x3fff840000000001ULL, 19);
+        const size_t MAX_LOG = 40;
+
+        // CRT constants, inverses are kept in montgomery form
+        constexpr uint64_t P1_INV_2 = mulmod(powmod(P1.p % P2.p, P2.p - 2, P2.p), P2.r1, P2.p);
+        constexpr uint64_t P1_MOD_3 = mulmod(P1.p % P3.p, P3.r1, P3.p);
+        constexpr uint64_t P12_INV_3 = mulmod(powmod(mulmod(P1.p, P2.p, P3.p), P3.p - 2, P3.p), P3.r1, P3.p);
+        constexpr __uint128_t P12 = (__uint128_t) P1.p * P2.p;
+
+        /*
+         * rt[len + j] = w^j, w is a primitive (2 * len)-th root of unity
+         * */
+        void roots(ntt_prime const &pr, uint64_t *rt, size_t n) {
+            size_t half = n >> 1;
+            uint64_t w = pr.to_mont(powmod(pr.g, (pr.p - 1) / n, pr.p));
+            rt[half] = pr.r1;
+            for (size_t j = 1; j < half; ++j) {
+                rt[half + j] = pr.mul(rt[half + j - 1], w);
+            }
+            for (size_t len = half >> 1; len; len >>= 1) {
+                for (size_t j = 0; j < len; ++j) {
+                    rt[len + j] = rt[2 * (len + j)];
+                }
+            }
+        }
+
+        // decimation in frequency, the output is bit-reversed
+        void forward(ntt_prime const &pr, uint64_t const *rt, uint64_t *a, size_t n) {
+            for (size_t len = n >> 1; len; len >>= 1) {
+                for (size_t i = 0; i < n; i += len << 1) {
+                    uint64_t *x = a + i, *y = a + i + len;
+                    for (size_t j = 0; j < len; ++j) {
+                        uint64_t u = x[j], v = y[j];
+                        x[j] = pr.add(u, v);
+                        y[j] = pr.mul(pr.sub(u, v), rt[len + j]);
+                    }
+                }
+            }
+        }
+
+        // decimation in time on bit-reversed input, w^(-j) = -w^(len - j)
+        void inverse(ntt_prime const &pr, uint64_t const *rt, uint64_t *a, size_t n) {
+            for (size_t len = 1; len < n; len <<= 1) {
+                for (size_t i = 0; i < n; i += len << 1) {
+                    uint64_t *x = a + i, *y = a + i + len;
+                    uint64_t u = x[0], v = y[0];
+                    x[0] = pr.add(u, v);
+                    y[0] = pr.sub(u, v);
+                    for (size_t j = 1; j < len; ++j) {
+                        u = x[j];
+                        v = pr.mul(y[j], rt[2 * len - j]);
+                        x[j] = pr.sub(u, v);
+                        y[j] = pr.add(u, v);
+                    }
+                }
+            }
+        }
+
+        void load(ntt_prime const &pr, uint64_t *dst, uint64_t const *src, size_t size, size_t n) {
+            for (size_t i = 0; i < size; ++i) {
+                dst[i] = pr.to_mont(src[i]);
+            }
+            memset(dst + size, 0, (n - size) * sizeof(uint64_t));
+        }
+
+        /*
+         * convolution of a and b modulo pr, the result is stored in fa in
+         * normal (not montgomery) form, squaring needs a single transform
+         * */
+        void convolve(ntt_prime const &pr, uint64_t *fa, uint64_t *fb, uint64_t *rt,
+                      uint64_t const *a, size_t na, uint64_t const *b, size_t nb, size_t n) {
+            roots(pr, rt, n);
+            load(pr, fa, a, na, n);
+            forward(pr, rt, fa, n);
+            if (a == b && na == nb) {
+                for (size_t i = 0; i < n; ++i) {
+                    fa[i] = pr.mul(fa[i], fa[i]);
+                }
+            } else {
+                load(pr, fb, b, nb, n);
+                forward(pr, rt, fb, n);
+                for (size_t i = 0; i < n; ++i) {
+                    fa[i] = pr.mul(fa[i], fb[i]);
+                }
+            }
+            inverse(pr, rt, fa, n);
+            // multiplying montgomery x * R by plain n^(-1) yields plain x / n
+            uint64_t ninv = powmod(n % pr.p, pr.p - 2, pr.p);
+            for (size_t i = 0; i < n; ++i) {
+                fa[i] = pr.mul(fa[i], ninv);
+            }
+        }
+    }
+
+    void _ntt_mul(uint64_t *res, uint64_t const *a, size_t na, uint64_t const *b, size_t nb) {
+        size_t lg = 0;
+        while ((size_t(1) << lg) < na + nb - 1) {
+            ++lg;
+        }
+        assert(lg <= MAX_LOG);
+        size_t n = size_t(1) << lg;
+
+        vector<uint64_t> buf(n * 5);
+        uint64_t *r1 = buf.data(), *r2 = r1 + n, *r3 = r2 + n, *tmp = r3 + n, *rt = tmp + n;
+        convolve(P1, r1, tmp, rt, a, na, b, nb, n);
+        convolve(P2, r2, tmp, rt, a, na, b, nb, n);
+        convolve(P3, r3, tmp, rt, a, na, b, nb, n);
+
+        // x = x1 + p1 * t2 + p1 * p2 * t3, carried into the result limb by limb
+        uint64_t c0 = 0, c1 = 0;
+        for (size_t i = 0; i < na + nb; ++i) {
+            uint64_t x0 = 0, x1 = 0, x2 = 0;
+            if (i < na + nb - 1) {
+                uint64_t x1p2 = r1[i] >= P2.p ? r1[i] - P2.p : r1[i];
+                uint64_t t2 = P2.mul(P2.sub(r2[i], x1p2), P1_INV_2);
+                __uint128_t x12 = (__uint128_t) P1.p * t2 + r1[i];
+
+                uint64_t x1p3 = r1[i] >= P3.p ? r1[i] - P3.p : r1[i];
+                uint64_t t2p3 = t2 >= P3.p ? t2 - P3.p : t2;
+                uint64_t x12p3 = P3.add(P3.mul(t2p3, P1_MOD_3), x1p3);
+                uint64_t t3 = P3.mul(P3.sub(r3[i], x12p3), P12_INV_3);
+
+                __uint128_t lo = (__uint128_t) (uint64_t) P12 * t3;
+                __uint128_t hi = (__uint128_t) (uint64_t) (P12 >> 64) * t3;
+                __uint128_t mid = (lo >> 64) + (uint64_t) hi;
+                x0 = (uint64_t) lo;
+                x1 = (uint64_t) mid;
+                x2 = (uint64_t) (hi >> 64) + (uint64_t) (mid >> 64);
+
+                __uint128_t s = (__uint128_t) x0 + (uint64_t) x12;
+                x0 = (uint64_t) s;
+                s = (__uint128_t) x1 + (uint64_t) (x12 >> 64) + (uint64_t) (s >> 64);
+                x1 = (uint64_t) s;
+                x2 += (uint64_t) (s >> 64);
+            }
+            __uint128_t s = (__uint128_t) x0 + c0;
+            res[i] = (uint64_t) s;
+            s = (__uint128_t) x1 + c1 + (uint64_t) (s >> 64);
+            c0 = (uint64_t) s;
+            c1 = x2 + (uint64_t) (s >> 64);
+        }
+    }
+}
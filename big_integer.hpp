@@ -6,9 +6,13 @@
 #define big_integer_hpp
 
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <utility>
+#include <stdexcept>
 #include <cmath>
 #include <stdint.h>
 #include <_core_arithmetics.hpp>
@@ -29,21 +33,82 @@ public:
     using digit_ptr = digit_t*;
     using const_ptr = digit_t const*;
     static const size_t DIGIT_SIZE = sizeof (digit_t);
+#ifdef ATOMIC_REFCOUNT
+    /* copies of one value may be made and dropped by several threads */
+    using refcount_policy = atomic_refcount;
+#else
+    using refcount_policy = plain_refcount;
+#endif
+
+    /*
+     * multiplication tier thresholds (in limbs of the shorter operand),
+     * karatsuba_threshold is taken as at least 2 and every other one as
+     * at least the threshold of the tier before it
+     * */
+    static size_t karatsuba_threshold;
+    static size_t toom3_threshold;
+    static size_t toom4_threshold;
+    static size_t ntt_threshold;
+
+    /* divisor and quotient limbs from which Burnikel-Ziegler division is used */
+    static size_t bz_threshold;
+
+    /* divisor and quotient limbs from which division goes through a newton reciprocal */
+    static size_t newton_threshold;
+
+    /* limbs from which radix conversion splits by powers of the limb-sized chunk */
+    static size_t radix_threshold;
+    /* threads used by the divide-and-conquer conversion, 1 means sequential */
+    static size_t radix_threads;
+    /* bytes the shared cache of conversion powers may hold (0 keeps nothing), powers past it are recomputed */
+    static size_t radix_cache_limit;
 
 private:
-    vector<digit_t>_data;
+    using digit_vector = vector<digit_t, 6, refcount_policy>;
+
+    digit_vector _data;
     bool _sgn = false;
 
-    static big_integer _karat_mul(big_integer const&, big_integer const&);
+    static void _karat_mul(digit_ptr, const_ptr, size_t, const_ptr, size_t, digit_ptr);
+    static void _karat_sqr(digit_ptr, const_ptr, size_t, digit_ptr);
+    static void _karat_combine(digit_ptr, size_t, digit_ptr, size_t, bool);
+    static size_t _karat_threshold();
+    static size_t _toom3_threshold();
+    static size_t _toom4_threshold();
+    static size_t _ntt_threshold();
+    static size_t _karat_scratch(size_t);
+    static bool _abs_sub(digit_ptr, const_ptr, size_t, const_ptr, size_t);
+    static big_integer _toom3_mul(big_integer const&, big_integer const&);
+    static big_integer _toom4_mul(big_integer const&, big_integer const&);
     static int _compare(const_ptr, const_ptr, size_t, size_t);
-    digit_t _read_digit(const std::string&, size_t, size_t) noexcept;
-    big_integer _division_impl(big_integer const&);
+    static digit_t _read_digit(char const*, size_t, unsigned);
+    static big_integer _from_radix(char const*, size_t, unsigned);
+    static big_integer _read_radix(std::streambuf&, unsigned);
+    void _division_impl(big_integer const&, big_integer&);
+    static void _bz_divide(big_integer const&, big_integer const&, big_integer&, big_integer&);
+    static void _bz_div_2n_1n(big_integer const&, big_integer const&, size_t, big_integer&, big_integer&);
+    static void _bz_div_3n_2n(big_integer const&, big_integer const&, size_t, big_integer&, big_integer&);
+    static void _newton_divide(big_integer const&, big_integer const&, big_integer&, big_integer&);
+    static big_integer _newton_inverse(big_integer const&, size_t);
+    static big_integer _approx_reciprocal(big_integer const&, size_t);
+    static big_integer _radix_power(unsigned, size_t);
+    static big_integer _radix_pow(unsigned, size_t);
+    static size_t _radix_digits(big_integer const&, unsigned);
+    static void _to_radix(big_integer const&, unsigned, char*, size_t, size_t);
     big_integer &_apply_bitwise(big_integer const& bi, digit_t (*f)(digit_t, digit_t));
     big_integer &_naive_mul(big_integer const&);
+    big_integer &_karat_mul(big_integer const&);
+    big_integer &_unbalanced_mul(big_integer const&);
+    big_integer &_naive_sqr();
+    big_integer &_karat_sqr();
+    big_integer &_ntt_mul(big_integer const&);
 
     void _normalize();
-    big_integer _higher(size_t) const;
-    big_integer _lower(size_t) const;
+    size_t _bits() const;
+    big_integer _slice(size_t, size_t) const;
+    big_integer &_assign_reserved(big_integer const&);
+    big_integer &_add_shifted(big_integer const&, size_t);
+    big_integer &_div_exact(digit_t);
     big_integer &_shift_left(size_t);
     big_integer &_shift_right(size_t);
 
@@ -58,6 +123,26 @@ public:
     explicit big_integer(const std::string&);
     static big_integer from_unsigned_long(uint64_t);
     static big_integer from_uint128_t(__uint128_t);
+    /* bases 2 to 36, letters in either case, throws std::invalid_argument */
+    static big_integer from_string(std::string_view, int);
+    /*
+     * magnitude as count words of size bytes, like mpz_import / mpz_export:
+     * order 1 / -1 puts the most / least significant word first,
+     * endian 1 / -1 / 0 is big / little / native byte order inside a word
+     * */
+    static big_integer import_bytes(void const*, size_t, int, size_t, int);
+    /*
+     * file: 32-byte header (magic, version, sign, limb count, checksum)
+     * followed by the raw little-endian limbs; load maps the file and
+     * shares the mapping copy-on-write, throws std::system_error on i/o
+     * errors and std::runtime_error on a malformed file
+     * */
+    static big_integer load(std::string const&, bool verify = true);
+
+    /* caches the powers needed to convert numbers of up to the given digit count */
+    static void warm_radix_cache(int, size_t);
+    static size_t radix_cache_bytes();
+    static void clear_radix_cache();
 
     big_integer& operator=(const big_integer&) = default;
     big_integer& operator=(big_integer&&) noexcept;
@@ -66,6 +151,18 @@ public:
     ~big_integer() noexcept = default;
     bool is_zero() const noexcept;
     big_integer& div_long_short(uint64_t, uint64_t &);
+    big_integer& div_long_short(_core::precomputed_divisor const&, uint64_t &);
+    big_integer& square();
+    big_integer reciprocal(size_t) const;
+    /* words of the given size export_bytes writes, 0 for zero */
+    size_t export_words(size_t) const;
+    size_t export_bytes(void*, int, size_t, int) const;
+    void save(std::string const&) const;
+
+    /* quotient and remainder of a single division, rounded as / and % */
+    static std::pair<big_integer, big_integer> divmod(big_integer const&, big_integer const&);
+    /* q, r = a / b, a % b into the buffers of q and r when they are unique and large enough */
+    static void divmod(big_integer&, big_integer&, big_integer const&, big_integer const&);
 
     big_integer& operator+=(const big_integer&);
     big_integer& operator-=(const big_integer&);
@@ -91,6 +188,11 @@ public:
     bool unique() const;
     size_t count() const;
     void detach();
+    /* deep copy from the current memory resource, e.g. to keep a value past its arena */
+    big_integer clone() const;
+    /* room for a magnitude of the given bits, kept by += and -= as they grow the value */
+    void reserve_bits(size_t);
+    void shrink_to_fit();
 
     friend bool operator==(const big_integer&, const big_integer&);
     friend bool operator!=(const big_integer&, const big_integer&);
@@ -112,8 +214,16 @@ public:
     friend big_integer operator^(big_integer, const big_integer&);
 
     friend std::string to_string(const big_integer&);
+    friend std::string to_string(const big_integer&, int);
+    /* exact output size of to_chars, including the sign */
+    friend size_t chars_needed(const big_integer&, int);
+    friend std::to_chars_result to_chars(char*, char*, const big_integer&, int);
+    friend std::from_chars_result from_chars(char const*, char const*, big_integer&, int);
     friend std::ostream& operator<<(std::ostream&, const big_integer&);
     friend std::istream& operator>>(std::istream&, big_integer&);
+    /* varint of (byte length << 1 | sign), then the little-endian magnitude */
+    friend std::ostream& write_binary(std::ostream&, const big_integer&);
+    friend std::istream& read_binary(std::istream&, big_integer&);
 };
 
 #endif /* big_integer_hpp */
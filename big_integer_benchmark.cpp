@@ -0,0 +1,306 @@
+/*
+    author dzhiblavi
+ */
+
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "big_integer.hpp"
+
+namespace {
+    big_integer rand_limbs(size_t n, std::mt19937_64 &gen) {
+        big_integer result;
+        for (size_t i = 0; i != n; ++i) {
+            result <<= 64;
+            result += big_integer::from_unsigned_long(gen());
+        }
+        return result;
+    }
+
+    template<typename F>
+    double measure(F f) {
+        size_t reps = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{};
+        do {
+            f();
+            ++reps;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.2);
+        return elapsed.count() * 1e3 / reps;
+    }
+
+    /*
+     * each column applies its tier on the top level only,
+     * the recursive products fall back to the default dispatch
+     * */
+    struct tier {
+        const char *name;
+        bool toom3;
+        bool toom4;
+        bool ntt;
+    };
+
+    void bench_mul() {
+        std::mt19937_64 gen(42);
+        tier const tiers[] = {
+                {"karatsuba", false, false, false},
+                {"toom3", true, false, false},
+                {"toom4", true, true, false},
+                {"ntt", true, true, true},
+        };
+        size_t const t3 = big_integer::toom3_threshold;
+        size_t const t4 = big_integer::toom4_threshold;
+        size_t const tn = big_integer::ntt_threshold;
+
+        printf("%10s", "limbs");
+        for (tier const &t : tiers) {
+            printf("%14s", t.name);
+        }
+        printf("   (ms per product)\n");
+        for (size_t n = 256; n <= 65536; n *= 2) {
+            big_integer a = rand_limbs(n, gen);
+            big_integer b = rand_limbs(n, gen);
+            printf("%10zu", n);
+            for (tier const &t : tiers) {
+                big_integer::toom3_threshold = t.toom3 ? std::min(n, t3) : SIZE_MAX;
+                big_integer::toom4_threshold = t.toom4 ? std::min(n, t4) : SIZE_MAX;
+                big_integer::ntt_threshold = t.ntt ? n : SIZE_MAX;
+                printf("%14.3f", measure([&] { big_integer c = a * b; }));
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+        big_integer::toom3_threshold = t3;
+        big_integer::toom4_threshold = t4;
+        big_integer::ntt_threshold = tn;
+    }
+
+    void bench_sqr() {
+        std::mt19937_64 gen(7);
+        printf("%10s%14s%14s%10s   (ms, default dispatch)\n", "limbs", "a * b", "a * a", "ratio");
+        for (size_t n = 16; n <= 65536; n *= 4) {
+            big_integer a = rand_limbs(n, gen);
+            big_integer b = rand_limbs(n, gen);
+            double mul = measure([&] { big_integer c = a * b; });
+            double sqr = measure([&] { big_integer c = a * a; });
+            printf("%10zu%14.4f%14.4f%10.2f\n", n, mul, sqr, mul / sqr);
+            fflush(stdout);
+        }
+    }
+
+    void bench_div() {
+        std::mt19937_64 gen(9);
+        size_t const bz = big_integer::bz_threshold;
+        size_t const nt = big_integer::newton_threshold;
+        printf("%10s%14s%14s%14s   (ms, 2n / n limbs)\n", "limbs", "schoolbook", "bz", "newton");
+        for (size_t n = 32; n <= 65536; n *= 2) {
+            big_integer a = rand_limbs(2 * n, gen);
+            big_integer b = rand_limbs(n, gen);
+            printf("%10zu", n);
+            for (size_t col = 0; col != 3; ++col) {
+                if (col == 0 && n > 8192) {
+                    printf("%14s", "-");
+                    continue;
+                }
+                big_integer::bz_threshold = col == 0 ? SIZE_MAX : bz;
+                big_integer::newton_threshold = col == 2 ? std::min(n, nt) : SIZE_MAX;
+                printf("%14.3f", measure([&] { big_integer c = a / b; }));
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+        big_integer::bz_threshold = bz;
+        big_integer::newton_threshold = nt;
+    }
+
+    void bench_to_string() {
+        std::mt19937_64 gen(5);
+        size_t const rt = big_integer::radix_threshold;
+        printf("%10s%14s%14s   (ms per conversion)\n", "limbs", "short div", "d&c");
+        for (size_t n = 64; n <= 65536; n *= 4) {
+            big_integer a = rand_limbs(n, gen);
+            printf("%10zu", n);
+            for (size_t t : {SIZE_MAX, rt}) {
+                big_integer::radix_threshold = t;
+                if (t == SIZE_MAX && n > 4096) {
+                    printf("%14s", "-");
+                    continue;
+                }
+                printf("%14.3f", measure([&] { std::string s = to_string(a); }));
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+        big_integer::radix_threshold = rt;
+    }
+
+    void bench_from_string() {
+        std::mt19937_64 gen(6);
+        size_t const rt = big_integer::radix_threshold;
+        printf("%10s%14s%14s%14s   (ms per parse)\n", "limbs", "chunked", "d&c", "stream");
+        for (size_t n = 64; n <= 65536; n *= 4) {
+            std::string s = to_string(rand_limbs(n, gen));
+            printf("%10zu", n);
+            for (size_t t : {SIZE_MAX, rt}) {
+                big_integer::radix_threshold = t;
+                if (t == SIZE_MAX && n > 4096) {
+                    printf("%14s", "-");
+                    continue;
+                }
+                printf("%14.3f", measure([&] { big_integer a(s); }));
+                fflush(stdout);
+            }
+            std::istringstream in;
+            printf("%14.3f\n", measure([&] {
+                in.clear();
+                in.str(s);
+                big_integer a;
+                in >> a;
+            }));
+            fflush(stdout);
+        }
+        big_integer::radix_threshold = rt;
+    }
+
+    void bench_serialize() {
+        std::mt19937_64 gen(8);
+        printf("%10s%14s%14s%14s%14s   (ms per round trip)\n", "limbs", "decimal", "binary", "export", "import");
+        for (size_t n = 64; n <= 65536; n *= 4) {
+            big_integer a = rand_limbs(n, gen);
+            std::string buf(n * 8, '\0');
+            printf("%10zu", n);
+            printf("%14.3f", measure([&] { big_integer b(to_string(a)); }));
+            printf("%14.3f", measure([&] {
+                std::stringstream ss;
+                big_integer b;
+                write_binary(ss, a);
+                read_binary(ss, b);
+            }));
+            printf("%14.3f", measure([&] { a.export_bytes(&buf[0], 1, 8, 1); }));
+            printf("%14.3f\n", measure([&] { big_integer b = big_integer::import_bytes(buf.data(), n, 1, 8, 1); }));
+            fflush(stdout);
+        }
+    }
+
+    /*
+     * a copy and a drop of a shared buffer, the cost of the reference
+     * count policy alone; plain counts are only safe in one thread
+     * */
+    template<typename Refcount>
+    double copy_drop(size_t threads) {
+        const size_t reps = 100000;
+        vector<uint64_t, 6, Refcount> v(64);
+        double ms = measure([&] {
+            auto work = [&v] {
+                for (size_t i = 0; i != reps; ++i) {
+                    vector<uint64_t, 6, Refcount> c = v;
+                    asm volatile("" : : "g"(&c) : "memory");
+                }
+            };
+            std::vector<std::thread> pool;
+            for (size_t t = 1; t < threads; ++t) {
+                pool.emplace_back(work);
+            }
+            work();
+            for (std::thread &th : pool) {
+                th.join();
+            }
+        });
+        return ms * 1e6 / (reps * threads);
+    }
+
+    /*
+     * a request full of short-lived temporaries, run against operator new,
+     * the buffer cache in front of it, the per-thread size-class pool and
+     * an arena released per request
+     * */
+    void bench_alloc() {
+        std::mt19937_64 gen(10);
+        std::vector<big_integer> xs;
+        for (size_t i = 0; i != 64; ++i) {
+            xs.push_back(rand_limbs(8 + i % 8, gen));
+        }
+        auto request = [&] {
+            big_integer acc;
+            for (size_t i = 0; i + 1 < xs.size(); ++i) {
+                acc += (xs[i] + 1) * (xs[i + 1] << 3) - xs[i];
+            }
+            return acc;
+        };
+        arena_resource arena;
+        size_t const cached = buffer_cache::max_buffers;
+        printf("%14s%14s%14s%14s   (us per request)\n", "new", "cache", "pool", "arena");
+        buffer_cache::max_buffers = 0;
+        buffer_cache::trim();
+        printf("%14.2f", measure([&] { request(); }) * 1e3);
+        buffer_cache::max_buffers = cached;
+        printf("%14.2f", measure([&] { request(); }) * 1e3);
+        printf("%14.2f", measure([&] {
+            memory_scope scope(&pool_resource::thread_pool());
+            request();
+        }) * 1e3);
+        printf("%14.2f\n", measure([&] {
+            {
+                memory_scope scope(&arena);
+                request();
+            }
+            arena.release();
+        }) * 1e3);
+    }
+
+    /*
+     * a value built a limb at a time by <<= 64 and +=, with and without
+     * reserve_bits() up front
+     * */
+    void bench_accumulate() {
+        std::mt19937_64 gen(11);
+        printf("%10s%14s%14s   (us per value)\n", "limbs", "shift in", "reserved");
+        for (size_t n = 64; n <= 4096; n *= 4) {
+            std::vector<big_integer> limbs;
+            for (size_t i = 0; i != n; ++i) {
+                limbs.push_back(big_integer::from_unsigned_long(gen()));
+            }
+            printf("%10zu", n);
+            for (bool reserve : {false, true}) {
+                printf("%14.2f", measure([&] {
+                    big_integer r;
+                    if (reserve) {
+                        r.reserve_bits(64 * n);
+                    }
+                    for (big_integer const &l : limbs) {
+                        r <<= 64;
+                        r += l;
+                    }
+                }) * 1e3);
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+
+    void bench_refcount() {
+        size_t n = std::max<size_t>(2, std::thread::hardware_concurrency());
+        printf("%24s%14s   (ns per copy and drop)\n", "refcount", "time");
+        printf("%24s%14.2f\n", "plain", copy_drop<plain_refcount>(1));
+        printf("%24s%14.2f\n", "atomic", copy_drop<atomic_refcount>(1));
+        printf("%18s, %2zu thr%14.2f\n", "atomic", n, copy_drop<atomic_refcount>(n));
+    }
+}
+
+int main() {
+    bench_mul();
+    bench_sqr();
+    bench_div();
+    bench_to_string();
+    bench_from_string();
+    bench_serialize();
+    bench_refcount();
+    bench_alloc();
+    bench_accumulate();
+    return 0;
+}
@@ -5,6 +5,13 @@
 #include <algorithm>
 #include <utility>
 #include <random>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <system_error>
+#include <sstream>
+#include <iomanip>
+#include <sys/stat.h>
 #include "gtest/gtest.h"
 
 #include "big_integer.hpp"
@@ -661,3 +668,979 @@ TEST(correctness, div_randomized) {
         EXPECT_LT(residue, divisor);
     }
 }
+
+namespace {
+    big_integer rand_limbs(size_t n) {
+        static std::mt19937_64 gen(12345);
+        big_integer result;
+        for (size_t i = 0; i != n; ++i) {
+            result <<= 64;
+            result += big_integer::from_unsigned_long(gen());
+        }
+        return result;
+    }
+
+    // sets a global tunable for the scope, restored even when an assertion returns early
+    template<typename T>
+    struct value_guard {
+        T &ref;
+        T saved;
+
+        value_guard(T &r, T v) : ref(r), saved(r) {
+            ref = v;
+        }
+
+        value_guard(value_guard const &) = delete;
+        value_guard &operator=(value_guard const &) = delete;
+
+        ~value_guard() {
+            ref = saved;
+        }
+    };
+
+    struct thresholds_guard {
+        size_t karatsuba = big_integer::karatsuba_threshold;
+        size_t toom3 = big_integer::toom3_threshold;
+        size_t toom4 = big_integer::toom4_threshold;
+        size_t ntt = big_integer::ntt_threshold;
+
+        thresholds_guard(size_t k, size_t t3, size_t t4, size_t n) {
+            big_integer::karatsuba_threshold = k;
+            big_integer::toom3_threshold = t3;
+            big_integer::toom4_threshold = t4;
+            big_integer::ntt_threshold = n;
+        }
+
+        ~thresholds_guard() {
+            big_integer::karatsuba_threshold = karatsuba;
+            big_integer::toom3_threshold = toom3;
+            big_integer::toom4_threshold = toom4;
+            big_integer::ntt_threshold = ntt;
+        }
+    };
+
+    big_integer naive_mul(big_integer const &a, big_integer const &b) {
+        thresholds_guard g(SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX);
+        return a * b;
+    }
+}
+
+TEST(correctness, mul_karatsuba) {
+    thresholds_guard g(8, SIZE_MAX, SIZE_MAX, SIZE_MAX);
+    for (size_t n : {9, 17, 100, 333}) {
+        for (size_t m : {1, 8, 9, 50, 257}) {
+            big_integer a = rand_limbs(n);
+            big_integer b = -rand_limbs(m);
+            EXPECT_EQ(a * b, naive_mul(a, b));
+        }
+    }
+    big_integer ones = (big_integer(1) << (64 * 300)) - 1;
+    EXPECT_EQ(ones * ones, naive_mul(ones, ones));
+
+    // thresholds below 2 are clamped instead of recursing forever
+    for (size_t k : {0, 1, 2}) {
+        thresholds_guard low(k, SIZE_MAX, SIZE_MAX, SIZE_MAX);
+        big_integer a = rand_limbs(37), b = rand_limbs(20);
+        EXPECT_EQ(a * b, naive_mul(a, b));
+        EXPECT_EQ(a * a, naive_mul(a, a));
+    }
+}
+
+TEST(correctness, mul_toom3) {
+    thresholds_guard g(32, 300, SIZE_MAX, SIZE_MAX);
+    for (size_t n : {700, 1001}) {
+        big_integer a = rand_limbs(n);
+        big_integer b = -rand_limbs(n - 7);
+        big_integer ab = a * b;
+        EXPECT_EQ(ab, naive_mul(a, b));
+        EXPECT_EQ(ab / a, b);
+    }
+}
+
+TEST(correctness, mul_toom4) {
+    thresholds_guard g(32, 300, 300, SIZE_MAX);
+    for (size_t n : {900, 1500}) {
+        big_integer a = -rand_limbs(n);
+        big_integer b = -rand_limbs(n + 1);
+        big_integer ab = a * b;
+        EXPECT_EQ(ab, naive_mul(a, b));
+        EXPECT_GT(ab, 0);
+    }
+}
+
+TEST(correctness, mul_ntt) {
+    thresholds_guard g(32, 32, 32, 32);
+    for (size_t n : {130, 1000, 2049}) {
+        big_integer a = rand_limbs(n);
+        big_integer b = -rand_limbs(n + n / 3);
+        EXPECT_EQ(a * b, naive_mul(a, b));
+    }
+    big_integer ones = (big_integer(1) << (64 * 3000)) - 1;
+    EXPECT_EQ(ones * ones, naive_mul(ones, ones));
+
+    // thresholds out of order are raised to the tier before them
+    for (auto const &t : {std::vector<size_t>{32, 300, 8192, 100}, std::vector<size_t>{64, 0, 0, 0}}) {
+        thresholds_guard order(t[0], t[1], t[2], t[3]);
+        big_integer a = rand_limbs(700), b = rand_limbs(500);
+        EXPECT_EQ(a * b, naive_mul(a, b));
+        EXPECT_EQ(a * a, naive_mul(a, a));
+    }
+}
+
+TEST(correctness, square) {
+    size_t const tiers[][4] = {
+            {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+            {8, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+            {32, 300, SIZE_MAX, SIZE_MAX},
+            {32, 300, 300, SIZE_MAX},
+            {32, 32, 32, 32},
+    };
+    for (auto const &t : tiers) {
+        thresholds_guard g(t[0], t[1], t[2], t[3]);
+        for (size_t n : {1, 7, 33, 701, 1500}) {
+            big_integer a = rand_limbs(n);
+            big_integer b(a);
+            b.detach();
+            big_integer aa = a * a;
+            EXPECT_EQ(aa, naive_mul(a, b));
+            EXPECT_EQ(-a * a, -aa);
+            EXPECT_EQ(b.square(), aa);
+            a *= a;
+            EXPECT_EQ(a, aa);
+        }
+    }
+    big_integer ones = (big_integer(1) << (64 * 300)) - 1;
+    big_integer other(ones);
+    other.detach();
+    EXPECT_EQ(ones * ones, naive_mul(ones, other));
+    EXPECT_EQ(big_integer().square(), 0);
+}
+
+TEST(correctness, mul_unbalanced) {
+    thresholds_guard g(32, 300, 600, SIZE_MAX);
+    for (size_t n : {40, 301, 450, 700}) {
+        big_integer a = rand_limbs(n);
+        big_integer b = -rand_limbs(4321);
+        EXPECT_EQ(a * b, naive_mul(a, b));
+        EXPECT_EQ(b * a, naive_mul(a, b));
+    }
+}
+
+TEST(correctness, div_bz) {
+    for (size_t bz : {4, 17, 32}) {
+        value_guard<size_t> g(big_integer::bz_threshold, bz);
+        for (size_t n : {40, 129, 300}) {
+            big_integer a = rand_limbs(2 * n + 77);
+            big_integer b = -rand_limbs(n);
+            big_integer q, r;
+            {
+                value_guard<size_t> schoolbook(big_integer::bz_threshold, SIZE_MAX);
+                q = a / b;
+                r = a % b;
+            }
+            EXPECT_EQ(a / b, q);
+            EXPECT_EQ(a % b, r);
+            EXPECT_EQ(q * b + r, a);
+            EXPECT_LT(-r, -b);
+        }
+        big_integer p = (big_integer(1) << (64 * 200)) - 1;
+        big_integer s = (big_integer(1) << (64 * 90)) - 1;
+        EXPECT_EQ(p / s * s + p % s, p);
+        EXPECT_EQ(p * s / s, p);
+    }
+}
+
+TEST(correctness, div_limb_patterns) {
+    // limbs at the edges of the qhat estimate, several of them need an add-back
+    uint64_t const limbs[] = {0, 1, 1ULL << 63, UINT64_MAX - 1, UINT64_MAX};
+    std::mt19937_64 gen(11);
+    for (size_t it = 0; it != 2000; ++it) {
+        big_integer a, b;
+        for (size_t i = 0; i != 7; ++i) {
+            a = (a << 64) + big_integer::from_unsigned_long(limbs[gen() % 5]);
+        }
+        for (size_t i = 0; i != 3; ++i) {
+            b = (b << 64) + big_integer::from_unsigned_long(limbs[gen() % 5]);
+        }
+        if (b == 0) {
+            continue;
+        }
+        big_integer q = a / b, r = a % b;
+        EXPECT_EQ(q * b + r, a);
+        EXPECT_TRUE(r >= 0 && r < b);
+    }
+}
+
+TEST(correctness, divmod) {
+    for (size_t n : {1, 5, 200}) {
+        big_integer a = -rand_limbs(3 * n), b = rand_limbs(n);
+        auto qr = big_integer::divmod(a, b);
+        EXPECT_EQ(qr.first, a / b);
+        EXPECT_EQ(qr.second, a % b);
+
+        big_integer q = b, r = a;
+        big_integer::divmod(q, r, r, q);
+        EXPECT_EQ(q, a / b);
+        EXPECT_EQ(r, a % b);
+    }
+    auto qr = big_integer::divmod(7, -2);
+    EXPECT_EQ(qr.first, -3);
+    EXPECT_EQ(qr.second, 1);
+
+    // unique destinations keep their buffers, a normalized divisor needs no scratch
+    big_integer const b = rand_limbs(10) | (big_integer(1) << 639);
+    std::vector<big_integer> as;
+    for (size_t n : {12, 30, 10, 11, 3}) {
+        as.push_back(rand_limbs(n));
+        as.push_back(-as.back());
+    }
+    big_integer q, r;
+    q.reserve_bits(64 * 40);
+    r.reserve_bits(64 * 40);
+    for (big_integer const &a : as) {
+        big_integer::divmod(q, r, a, b);
+        EXPECT_EQ(q, a / b);
+        EXPECT_EQ(r, a % b);
+    }
+    buffer_cache::reset_stats();
+    for (big_integer const &a : as) {
+        big_integer::divmod(q, r, a, b);
+    }
+    buffer_cache::stats st = buffer_cache::local_stats();
+    EXPECT_EQ(st.hits + st.misses, 0u);
+
+    // the quotient may be the dividend itself
+    q = as[2];
+    big_integer::divmod(q, r, q, -b);
+    EXPECT_EQ(q, as[2] / -b);
+    EXPECT_EQ(r, as[2] % -b);
+}
+
+TEST(correctness, short_division_threads) {
+    // every thread divides by its own constant, nothing may be shared
+    std::vector<std::string> expected(4), got(4);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t != 4; ++t) {
+        pool.emplace_back([&got, &expected, t] {
+            std::mt19937_64 gen(t);
+            uint64_t d = gen() >> (16 * t);
+            _core::precomputed_divisor pd(d);
+            for (size_t it = 0; it != 200; ++it) {
+                big_integer a;
+                for (size_t i = 0; i != 20; ++i) {
+                    a = (a << 64) + big_integer::from_unsigned_long(gen());
+                }
+                uint64_t rm1, rm2;
+                big_integer q1 = a, q2 = a;
+                q1.div_long_short(d, rm1);
+                q2.div_long_short(pd, rm2);
+                if (q1 != q2 || rm1 != rm2 || q1 * big_integer::from_unsigned_long(d) + big_integer::from_unsigned_long(rm1) != a) {
+                    got[t] = "mismatch";
+                    return;
+                }
+                got[t] = to_string(q1);
+                expected[t] = to_string(a / big_integer::from_unsigned_long(d));
+                if (got[t] != expected[t]) {
+                    return;
+                }
+            }
+        });
+    }
+    for (std::thread &th : pool) {
+        th.join();
+    }
+    EXPECT_EQ(got, expected);
+
+    // a default constructed divisor divides by 1
+    uint64_t rm = 7;
+    EXPECT_EQ(_core::divd(12345, _core::precomputed_divisor{}, rm), 12345u);
+    EXPECT_EQ(rm, 0u);
+    EXPECT_EQ(_core::divd(~__uint128_t(0) >> 64, _core::precomputed_divisor(), rm), UINT64_MAX);
+    EXPECT_EQ(rm, 0u);
+}
+
+TEST(correctness, to_string_divide_and_conquer) {
+    for (size_t n : {1, 7, 100, 700}) {
+        big_integer a = rand_limbs(n);
+        big_integer p = big_integer(10);
+        for (size_t i = 0; i != 5; ++i) {
+            p *= p;
+        }
+        std::string expected, round;
+        {
+            value_guard<size_t> short_div(big_integer::radix_threshold, SIZE_MAX);
+            expected = to_string(-a);
+            round = to_string(a * p);
+        }
+        for (size_t rt : {2, 5, 64}) {
+            value_guard<size_t> g(big_integer::radix_threshold, rt);
+            EXPECT_EQ(to_string(-a), expected);
+            EXPECT_EQ(to_string(a * p), round);
+            EXPECT_EQ(round.substr(round.size() - 32), std::string(32, '0'));
+            value_guard<size_t> threads(big_integer::radix_threads, 4);
+            EXPECT_EQ(to_string(-a), expected);
+        }
+    }
+    EXPECT_EQ(to_string(big_integer(0)), "0");
+    EXPECT_EQ(to_string(big_integer::from_unsigned_long(UINT64_MAX)), "18446744073709551615");
+}
+
+TEST(correctness, from_string_divide_and_conquer) {
+    for (size_t n : {1, 7, 100, 700}) {
+        big_integer a = rand_limbs(n);
+        std::string s = to_string(a), zeros = "000" + s + std::string(40, '0');
+        big_integer expected;
+        {
+            value_guard<size_t> chunked(big_integer::radix_threshold, SIZE_MAX);
+            expected = big_integer(zeros);
+        }
+        for (size_t rt : {1, 3, 64}) {
+            value_guard<size_t> g(big_integer::radix_threshold, rt);
+            EXPECT_EQ(big_integer(s), a);
+            EXPECT_EQ(big_integer("-" + s), -a);
+            EXPECT_EQ(big_integer(zeros), expected);
+        }
+    }
+    EXPECT_EQ(big_integer("-0"), 0);
+    EXPECT_EQ(big_integer("000"), 0);
+}
+
+TEST(correctness, parse_digit_chunks) {
+    std::mt19937_64 gen(3);
+    for (size_t len = 0; len <= 19; ++len) {
+        for (size_t it = 0; it != 100; ++it) {
+            std::string s;
+            uint64_t expected = 0, got;
+            for (size_t i = 0; i != len; ++i) {
+                s.push_back(char('0' + gen() % 10));
+                expected = expected * 10 + (s.back() - '0');
+            }
+            EXPECT_TRUE(_core::_parse_digits(s.data(), len, got));
+            EXPECT_EQ(got, expected);
+            EXPECT_TRUE(_core::_all_digits(s.data(), len));
+            if (len) {
+                for (char c : {'/', ':', ' ', '\0', '\x80', '\xb0'}) {
+                    std::string t = s;
+                    t[gen() % len] = c;
+                    EXPECT_FALSE(_core::_parse_digits(t.data(), len, got));
+                    EXPECT_FALSE(_core::_all_digits(t.data(), len));
+                }
+            }
+        }
+    }
+}
+
+TEST(correctness, parse_errors) {
+    std::string digits(1000, '7');
+    for (std::string s : {"", "-", "+1", "12a", "1 2", "--1", "0x10"}) {
+        EXPECT_THROW(big_integer{s}, std::invalid_argument);
+    }
+    for (size_t pos : {0, 17, 500, 999}) {
+        std::string s = digits;
+        s[pos] = 'x';
+        EXPECT_THROW(big_integer{s}, std::invalid_argument);
+    }
+    std::istringstream in("123 4x5 6");
+    big_integer a = 1;
+    EXPECT_TRUE(bool(in >> a));
+    EXPECT_EQ(a, 123);
+    EXPECT_FALSE(bool(in >> a));
+    EXPECT_EQ(a, 123);
+}
+
+TEST(correctness, stream_input) {
+    for (size_t rt : {1, 3, 64}) {
+        value_guard<size_t> g(big_integer::radix_threshold, rt);
+        for (size_t n : {1, 19, 20, 300, 2431, 10000}) {
+            std::string s(n, '0');
+            for (char &c : s) {
+                c = '0' + rand() % 10;
+            }
+            std::istringstream in(s + " -00" + s + "\t0 -0\n");
+            big_integer a, b, c, d;
+            EXPECT_TRUE(bool(in >> a >> b >> c >> d));
+            EXPECT_EQ(a, big_integer(s));
+            EXPECT_EQ(b, -a);
+            EXPECT_EQ(c, 0);
+            EXPECT_EQ(d, 0);
+            EXPECT_FALSE(in.eof());
+            EXPECT_FALSE(bool(in >> d));
+            EXPECT_TRUE(in.eof());
+
+            std::istringstream tail(s);
+            EXPECT_TRUE(bool(tail >> b));
+            EXPECT_TRUE(tail.eof());
+            EXPECT_EQ(b, a);
+        }
+    }
+    big_integer a = 7;
+    for (std::string s : {"", "-", "- 1", "+1", "12a", "x"}) {
+        std::istringstream in(s);
+        EXPECT_FALSE(bool(in >> a));
+        EXPECT_EQ(a, 7);
+    }
+}
+
+TEST(correctness, radix_cache) {
+    value_guard<size_t> g(big_integer::radix_threshold, 2);
+    big_integer a = rand_limbs(200) + 1;
+    std::string s = to_string(a), s7 = to_string(a, 7);
+
+    big_integer::clear_radix_cache();
+    EXPECT_EQ(big_integer::radix_cache_bytes(), 0u);
+    big_integer::warm_radix_cache(10, s.size());
+    size_t warm = big_integer::radix_cache_bytes();
+    EXPECT_GT(warm, 8 * 100u);
+    EXPECT_EQ(to_string(a), s);
+    EXPECT_EQ(big_integer(s), a);
+    EXPECT_EQ(big_integer::radix_cache_bytes(), warm);
+    big_integer::warm_radix_cache(16, 1000000);
+    EXPECT_EQ(big_integer::radix_cache_bytes(), warm);
+
+    for (size_t cap : {0, 200}) {
+        big_integer::clear_radix_cache();
+        value_guard<size_t> limit(big_integer::radix_cache_limit, cap);
+        EXPECT_EQ(to_string(a), s);
+        EXPECT_EQ(to_string(a, 7), s7);
+        EXPECT_EQ(big_integer(s), a);
+        EXPECT_EQ(big_integer::from_string(s7, 7), a);
+        EXPECT_LE(big_integer::radix_cache_bytes(), cap);
+    }
+
+    // levels squared concurrently are published once
+    big_integer::clear_radix_cache();
+    std::vector<std::string> got(4);
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i != got.size(); ++i) {
+        pool.emplace_back([&got, &a, i] { got[i] = to_string(a, i % 2 ? 7 : 10); });
+    }
+    for (std::thread &th : pool) {
+        th.join();
+    }
+    EXPECT_EQ(got, std::vector<std::string>({s, s7, s, s7}));
+    size_t shared = big_integer::radix_cache_bytes();
+    big_integer::clear_radix_cache();
+    EXPECT_EQ(to_string(a), s);
+    EXPECT_EQ(to_string(a, 7), s7);
+    EXPECT_EQ(big_integer::radix_cache_bytes(), shared);
+}
+
+TEST(correctness, radix_table) {
+    for (unsigned base = 2; base <= 36; ++base) {
+        _core::radix_chunk ch = _core::_radix_chunk(base);
+        uint64_t p = 1;
+        for (size_t e = 0; e <= ch.digits; ++e, p *= base) {
+            EXPECT_EQ(_core::_small_pow(base, e), p);
+        }
+        EXPECT_EQ(ch.power, _core::_small_pow(base, ch.digits));
+        EXPECT_GT((__uint128_t) ch.power * base, (__uint128_t) UINT64_MAX);
+    }
+    EXPECT_EQ(_core::_pow10(0), 1u);
+    EXPECT_EQ(_core::_pow10(18), 1000000000000000000u);
+}
+
+TEST(correctness, radix_conversions) {
+    for (int base = 2; base <= 36; ++base) {
+        for (size_t n : {1, 3, 50}) {
+            big_integer a = rand_limbs(n), b = a;
+            std::string naive;
+            while (b != 0) {
+                naive.push_back("0123456789abcdefghijklmnopqrstuvwxyz"[std::stoi(to_string(b % base))]);
+                b /= base;
+            }
+            std::reverse(naive.begin(), naive.end());
+            for (size_t rt : {2, 64}) {
+                value_guard<size_t> g(big_integer::radix_threshold, rt);
+                EXPECT_EQ(to_string(a, base), naive);
+                EXPECT_EQ(to_string(-a, base), "-" + naive);
+                EXPECT_EQ(big_integer::from_string(naive, base), a);
+                std::string upper = naive;
+                std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+                EXPECT_EQ(big_integer::from_string("-" + upper, base), -a);
+            }
+        }
+        EXPECT_EQ(to_string(big_integer(0), base), "0");
+        EXPECT_EQ(big_integer::from_string("000", base), 0);
+    }
+    EXPECT_EQ(to_string(big_integer(-255), 16), "-ff");
+    EXPECT_EQ(big_integer::from_string("zz", 36), 36 * 36 - 1);
+    EXPECT_THROW(big_integer::from_string("12", 2), std::invalid_argument);
+    EXPECT_THROW(big_integer::from_string("g", 16), std::invalid_argument);
+    EXPECT_THROW(big_integer::from_string("1", 37), std::invalid_argument);
+    EXPECT_THROW(to_string(big_integer(1), 1), std::invalid_argument);
+}
+
+TEST(correctness, to_chars_from_chars) {
+    for (int base : {2, 3, 10, 16, 36}) {
+        big_integer p = 1;
+        for (size_t e = 0; e != 8; ++e) {
+            for (size_t i = 0; i != 37; ++i) {
+                p *= base;
+            }
+            for (big_integer a : {p - 1, p, -p, -(p + 1), p * rand_limbs(2)}) {
+                for (size_t rt : {2, 64}) {
+                    value_guard<size_t> g(big_integer::radix_threshold, rt);
+                    std::string s = to_string(a, base);
+                    ASSERT_EQ(chars_needed(a, base), s.size());
+                    std::string buf(s.size() + 1, '#');
+                    auto res = to_chars(&buf[0], &buf[0] + buf.size(), a, base);
+                    EXPECT_EQ(res.ec, std::errc());
+                    EXPECT_EQ(res.ptr, &buf[0] + s.size());
+                    EXPECT_EQ(buf, s + "#");
+                    res = to_chars(&buf[0], &buf[0] + s.size() - 1, a, base);
+                    EXPECT_EQ(res.ec, std::errc::value_too_large);
+
+                    big_integer b;
+                    buf = s + "!";
+                    auto fr = from_chars(buf.data(), buf.data() + buf.size(), b, base);
+                    EXPECT_EQ(fr.ec, std::errc());
+                    EXPECT_EQ(fr.ptr, buf.data() + s.size());
+                    EXPECT_EQ(b, a);
+                }
+            }
+        }
+    }
+    EXPECT_EQ(chars_needed(big_integer(0), 10), 1u);
+    char buf[4];
+    EXPECT_EQ(to_chars(buf, buf + 1, big_integer(0), 10).ptr, buf + 1);
+    EXPECT_EQ(buf[0], '0');
+    big_integer b = 5;
+    char const *junk = "-x1";
+    auto fr = from_chars(junk, junk + 3, b, 10);
+    EXPECT_EQ(fr.ec, std::errc::invalid_argument);
+    EXPECT_EQ(fr.ptr, junk);
+    EXPECT_EQ(b, 5);
+
+    // short values are printed without touching the limb allocator
+    big_integer const x = -rand_limbs(40);
+    std::string const expected = to_string(x);
+    std::string out(expected.size(), '#');
+    char wide[4096];
+    std::ostringstream os;
+    buffer_cache::reset_stats();
+    for (int base : {7, 16, 36}) {
+        EXPECT_EQ(to_chars(wide, wide + sizeof wide, x, base).ec, std::errc());
+    }
+    EXPECT_EQ(to_chars(&out[0], &out[0] + out.size(), x, 10).ptr, &out[0] + out.size());
+    os << x;
+    buffer_cache::stats st = buffer_cache::local_stats();
+    EXPECT_EQ(st.hits + st.misses, 0u);
+    EXPECT_EQ(out, expected);
+    EXPECT_EQ(os.str(), expected);
+    os.str("");
+    os << std::setw(expected.size() + 2) << std::setfill('*') << x;
+    EXPECT_EQ(os.str(), "**" + expected);
+}
+
+TEST(correctness, export_import_bytes) {
+    big_integer x = big_integer::from_string("0102030405060708090a0b", 16);
+    unsigned char buf[16];
+    EXPECT_EQ(x.export_words(1), 11u);
+    EXPECT_EQ(x.export_bytes(buf, 1, 1, 0), 11u);
+    for (size_t i = 0; i != 11; ++i) {
+        EXPECT_EQ(buf[i], i + 1);
+    }
+    EXPECT_EQ(x.export_bytes(buf, -1, 4, 1), 3u);
+    unsigned char const words[] = {8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3};
+    EXPECT_TRUE(std::equal(words, words + 12, buf));
+    EXPECT_EQ(big_integer::import_bytes(words, 3, -1, 4, 1), x);
+    EXPECT_THROW(x.export_bytes(buf, 0, 1, 0), std::invalid_argument);
+    EXPECT_THROW(big_integer::import_bytes(buf, 1, 1, 0, 0), std::invalid_argument);
+
+    for (big_integer const &a : {big_integer(0), rand_limbs(1), -rand_limbs(5) << 3, rand_limbs(9)}) {
+        for (int order : {1, -1}) {
+            for (size_t size : {1, 2, 3, 8, 13}) {
+                for (int endian : {-1, 0, 1}) {
+                    std::vector<unsigned char> out(a.export_words(size) * size + 1, 0xee);
+                    size_t count = a.export_bytes(out.data(), order, size, endian);
+                    EXPECT_EQ(count, a.export_words(size));
+                    EXPECT_EQ(out.back(), 0xee);
+                    EXPECT_EQ(big_integer::import_bytes(out.data(), count, order, size, endian), a < 0 ? -a : a);
+                }
+            }
+        }
+    }
+}
+
+TEST(correctness, binary_stream) {
+    std::vector<big_integer> v = {0, 1, -1, 127, -128, rand_limbs(3), -rand_limbs(300), big_integer(1) << 1000};
+    std::stringstream ss;
+    for (big_integer const &a : v) {
+        write_binary(ss, a);
+    }
+    EXPECT_EQ(ss.str().substr(0, 5), std::string("\0\2\1\3\1", 5));
+    for (big_integer const &a : v) {
+        big_integer b;
+        EXPECT_TRUE(bool(read_binary(ss, b)));
+        EXPECT_EQ(b, a);
+    }
+    big_integer b = 5;
+    EXPECT_FALSE(bool(read_binary(ss, b)));
+    EXPECT_EQ(b, 5);
+
+    std::stringstream full;
+    write_binary(full, rand_limbs(2));
+    std::stringstream cut(full.str().substr(0, full.str().size() - 1));
+    EXPECT_FALSE(bool(read_binary(cut, b)));
+    EXPECT_EQ(b, 5);
+
+    // malformed headers: absurd and merely large lengths, overlong varints
+    auto varint = [](uint64_t x) {
+        std::string r;
+        for (; x >= 0x80; x >>= 7) {
+            r += char(x | 0x80);
+        }
+        return r + char(x);
+    };
+    for (std::string const &frame : {std::string(8, '\xff') + '\x3f', varint(uint64_t(1) << 31) + "abc",
+                                     std::string(9, '\x80') + '\x02', std::string(10, '\x80') + '\x00'}) {
+        std::stringstream in(frame);
+        EXPECT_FALSE(bool(read_binary(in, b)));
+        EXPECT_EQ(b, 5);
+    }
+    std::stringstream padded(std::string("\x84") + std::string(8, '\x80') + '\x00' + "\x01\x02");
+    EXPECT_TRUE(bool(read_binary(padded, b)));
+    EXPECT_EQ(b, 0x201);
+}
+
+TEST(correctness, atomic_refcount_sharing) {
+    using limbs = vector<uint64_t, 6, atomic_refcount>;
+    limbs v(1000);
+    for (size_t i = 0; i != v.size(); ++i) {
+        v[i] = i;
+    }
+    std::atomic<size_t> bad{0};
+    std::vector<std::thread> pool;
+    for (uint64_t t = 1; t <= 4; ++t) {
+        pool.emplace_back([&v, &bad, t] {
+            for (size_t it = 0; it != 2000; ++it) {
+                limbs c = v;
+                if (it % 7 == 0) {
+                    c.detach();
+                    c[0] = t;
+                    bad += c[0] != t;
+                }
+                bad += c.size() != 1000 || c[999] != 999;
+            }
+        });
+    }
+    for (std::thread &th : pool) {
+        th.join();
+    }
+    EXPECT_EQ(bad, 0u);
+    EXPECT_EQ(v[0], 0u);
+    EXPECT_TRUE(v.unique());
+}
+
+TEST(correctness, memory_resources) {
+    big_integer a = rand_limbs(300), b = -rand_limbs(170);
+    big_integer prod = a * b, quot = a / b;
+    std::string dec = to_string(a);
+    big_integer::clear_radix_cache();
+
+    big_integer kept, small;
+    {
+        arena_resource arena(1024);
+        big_integer p, q;
+        {
+            memory_scope scope(&arena);
+            p = a * b;
+            q = a / b;
+            EXPECT_EQ(to_string(a), dec);
+            EXPECT_EQ(big_integer(dec), a);
+            small = q % 1000;
+        }
+        EXPECT_GT(arena.reserved(), 8 * 470u);
+        EXPECT_EQ(p, prod);
+        EXPECT_EQ(q, quot);
+        kept = p.clone();
+    }
+    EXPECT_EQ(kept, prod);
+    EXPECT_EQ(small, quot % 1000);
+    // the powers cached inside the scope did not go to the arena
+    EXPECT_EQ(to_string(a), dec);
+
+    {
+        memory_scope scope(&pool_resource::thread_pool());
+        for (size_t i = 0; i != 20; ++i) {
+            big_integer c = a * b - big_integer(i);
+            c /= b;
+            EXPECT_EQ(c, a);
+        }
+        kept = (a * b).clone();
+    }
+    EXPECT_EQ(kept, prod);
+    pool_resource::thread_pool().release();
+}
+
+TEST(correctness, buffer_cache) {
+    big_integer a = rand_limbs(40), b = rand_limbs(50);
+    big_integer prod = a * b;
+
+    buffer_cache::trim();
+    buffer_cache::reset_stats();
+    for (size_t i = 0; i != 100; ++i) {
+        EXPECT_EQ(a * b, prod);
+    }
+    buffer_cache::stats st = buffer_cache::local_stats();
+    EXPECT_GT(st.hits, 100u);
+    EXPECT_LT(st.misses, 10u);
+    EXPECT_GT(st.cached_bytes, 0u);
+
+    {
+        value_guard<size_t> buffers(buffer_cache::max_buffers, 0);
+        buffer_cache::trim();
+        buffer_cache::reset_stats();
+        EXPECT_EQ(a * b, prod);
+        EXPECT_EQ(buffer_cache::local_stats().hits, 0u);
+        EXPECT_EQ(buffer_cache::local_stats().cached_bytes, 0u);
+    }
+    {
+        value_guard<size_t> bytes(buffer_cache::max_bytes, 64);
+        buffer_cache::reset_stats();
+        for (size_t i = 0; i != 10; ++i) {
+            EXPECT_EQ(a * b, prod);
+        }
+        EXPECT_EQ(buffer_cache::local_stats().hits, 0u);
+    }
+
+    // buffers made in one thread and dropped in another
+    std::vector<big_integer> made(16);
+    std::thread producer([&] {
+        for (size_t i = 0; i != made.size(); ++i) {
+            made[i] = a * big_integer(i + 1);
+        }
+        EXPECT_GT(buffer_cache::local_stats().misses, 0u);
+    });
+    producer.join();
+    for (size_t i = 0; i != made.size(); ++i) {
+        EXPECT_EQ(made[i] / a, i + 1);
+    }
+    made.clear();
+    buffer_cache::trim();
+}
+
+TEST(correctness, reserve_growth) {
+    // growing a limb at a time only moves the buffer a logarithmic number of times
+    vector<uint64_t> v;
+    size_t moves = 0;
+    for (size_t i = 1; i != 4096; ++i) {
+        uint64_t const *p = v.data();
+        v.resize(i);
+        v[i - 1] = i;
+        moves += v.data() != p;
+    }
+    EXPECT_LT(moves, 16u);
+    EXPECT_GT(v.capacity(), v.size());
+
+    // spare capacity of a shared buffer is not written in place
+    vector<uint64_t> w = v;
+    w.resize(w.size() + 1);
+    w.back() = 0;
+    EXPECT_NE(w.data(), v.data());
+    w = v;
+    w.push_back(0);
+    EXPECT_NE(w.data(), v.data());
+    w = v;
+    w.reserve(20000);
+    EXPECT_GE(w.capacity(), 20000u);
+    EXPECT_EQ(v.count(), 1u);
+
+    uint64_t const *p = v.data();
+    v.reserve(10000);
+    EXPECT_GE(v.capacity(), 10000u);
+    EXPECT_NE(v.data(), p);
+    p = v.data();
+    v.resize(10000);
+    EXPECT_EQ(v.data(), p);
+    v.resize(5000);
+    v.shrink_to_fit();
+    EXPECT_GE(v.capacity(), 5000u);
+    EXPECT_LT(v.capacity(), 10000u);
+    v.resize(3);
+    v.shrink_to_fit();
+    EXPECT_TRUE(v.small());
+    for (size_t i = 0; i != 3; ++i) {
+        EXPECT_EQ(v[i], i + 1);
+    }
+
+    // a reserved accumulator is never reallocated, also across zero
+    std::vector<big_integer> terms;
+    big_integer sum;
+    for (size_t i = 0; i != 64; ++i) {
+        terms.push_back(rand_limbs(8) << (64 * i));
+        if (i % 3 == 0) {
+            terms.back() = -terms.back();
+        }
+        sum += terms.back();
+    }
+    big_integer acc, neg;
+    acc.reserve_bits(64 * 80);
+    neg.reserve_bits(64 * 80);
+    buffer_cache::reset_stats();
+    for (big_integer const &t : terms) {
+        acc += t;
+        neg -= t;
+    }
+    EXPECT_EQ(acc, sum);
+    EXPECT_EQ(neg, -sum);
+    acc -= acc;
+    EXPECT_EQ(acc, 0);
+    acc += terms.back();
+    EXPECT_EQ(acc, terms.back());
+    buffer_cache::stats st = buffer_cache::local_stats();
+    EXPECT_EQ(st.hits + st.misses, 0u);
+
+    acc.shrink_to_fit();
+    EXPECT_EQ(acc, terms.back());
+
+    // the smaller magnitude minus the larger one, with and without a borrow out of the low limbs
+    big_integer const big = (big_integer(1) << 640) + 5;
+    for (big_integer x : {big_integer(7), big_integer(3), rand_limbs(4), (big_integer(1) << 640) - 1}) {
+        big_integer y = x;
+        y -= big;
+        EXPECT_EQ(y + big, x);
+        EXPECT_EQ(-y, big - x);
+    }
+}
+
+TEST(correctness, save_load_mapped) {
+    std::string const path = "big_integer_file_test.bin";
+    for (big_integer const &a : {big_integer(0), big_integer(-5), rand_limbs(4), -rand_limbs(300)}) {
+        a.save(path);
+        EXPECT_EQ(big_integer::load(path), a);
+    }
+
+    // the mapping is read-only, every mutation has to detach first
+    big_integer const a = -rand_limbs(300), c = rand_limbs(170);
+    a.save(path);
+    big_integer b = big_integer::load(path);
+    std::vector<big_integer (*)(big_integer, big_integer const &)> ops = {
+            [](big_integer x, big_integer const &y) { return x += y; },
+            [](big_integer x, big_integer const &y) { return x -= y; },
+            [](big_integer x, big_integer const &y) { return x *= y; },
+            [](big_integer x, big_integer const &y) { return x /= y; },
+            [](big_integer x, big_integer const &y) { return x %= y; },
+            [](big_integer x, big_integer const &y) { return x &= y; },
+            [](big_integer x, big_integer const &y) { return x |= y; },
+            [](big_integer x, big_integer const &y) { return x ^= y; },
+    };
+    for (auto op : ops) {
+        EXPECT_EQ(op(b, c), op(a, c));
+        EXPECT_EQ(op(c, b), op(c, a));
+        EXPECT_EQ(op(b, b), op(a, a));
+    }
+    big_integer x = b;
+    EXPECT_EQ(++x, a + 1);
+    x = b;
+    EXPECT_EQ(--x, a - 1);
+    x = b;
+    EXPECT_EQ(x <<= 7, a << 7);
+    x = b;
+    EXPECT_EQ(x >>= 70, a >> 70);
+    x = b;
+    EXPECT_EQ(x.square(), a * a);
+    x = b;
+    uint64_t rx, ra;
+    x.div_long_short(1000003, rx);
+    EXPECT_EQ(x, big_integer(a).div_long_short(1000003, ra));
+    EXPECT_EQ(rx, ra);
+    EXPECT_EQ(to_string(b), to_string(a));
+    EXPECT_EQ(b, a);
+
+    // saving over the file a live value is mapped from replaces it, the mapping keeps the old contents
+    b.save(path);
+    EXPECT_EQ(b, a);
+    big_integer d = b + 1;
+    d.save(path);
+    EXPECT_EQ(b, a);
+    EXPECT_EQ(big_integer::load(path), a + 1);
+    b = big_integer::load(path);
+    a.save(path);
+    EXPECT_EQ(b, a + 1);
+    EXPECT_EQ(big_integer::load(path), a);
+    b = big_integer::load(path);
+
+    // a new file follows the umask, a replaced one keeps its mode
+    auto mode = [&path] {
+        struct stat st{};
+        stat(path.c_str(), &st);
+        return st.st_mode & 0777;
+    };
+    std::remove(path.c_str());
+    mode_t mask = umask(077);
+    a.save(path);
+    EXPECT_EQ(mode(), 0600u);
+    umask(022);
+    a.save(path);
+    EXPECT_EQ(mode(), 0600u);
+    chmod(path.c_str(), 0640);
+    a.save(path);
+    EXPECT_EQ(mode(), 0640u);
+    umask(mask);
+    b = big_integer::load(path);
+
+    FILE *f = fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(f);
+    fseek(f, 1000, SEEK_SET);
+    int byte = fgetc(f);
+    fseek(f, 1000, SEEK_SET);
+    fputc(byte ^ 1, f);
+    fclose(f);
+    b = big_integer();
+    EXPECT_THROW(big_integer::load(path), std::runtime_error);
+    EXPECT_NE(big_integer::load(path, false), a);
+    f = fopen(path.c_str(), "wb");
+    fputs("not a number", f);
+    fclose(f);
+    EXPECT_THROW(big_integer::load(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(big_integer::load(path), std::system_error);
+}
+
+TEST(correctness, reciprocal) {
+    for (size_t n : {1, 3, 40}) {
+        big_integer b = rand_limbs(n) >> 5;
+        for (size_t bits : {size_t(0), size_t(10), 64 * n - 6, 64 * n + 1, 200 * n, size_t(2000)}) {
+            big_integer p = big_integer(1) << bits;
+            EXPECT_EQ(b.reciprocal(bits), p / b);
+            EXPECT_EQ((-b).reciprocal(bits), p / b);
+        }
+    }
+    EXPECT_EQ((big_integer(1) << 500).reciprocal(700), big_integer(1) << 200);
+}
+
+TEST(correctness, div_newton) {
+    for (size_t nt : {2, 8, 33}) {
+        value_guard<size_t> g(big_integer::newton_threshold, nt);
+        for (size_t n : {40, 129, 300}) {
+            big_integer a = rand_limbs(2 * n + 77);
+            big_integer b = -rand_limbs(n);
+            big_integer q, r;
+            {
+                value_guard<size_t> classic(big_integer::newton_threshold, SIZE_MAX);
+                q = a / b;
+                r = a % b;
+            }
+            EXPECT_EQ(a / b, q);
+            EXPECT_EQ(a % b, r);
+        }
+        big_integer p = (big_integer(1) << (64 * 200)) - 1;
+        big_integer s = (big_integer(1) << (64 * 90)) - 1;
+        EXPECT_EQ(p / s * s + p % s, p);
+        EXPECT_EQ(p * s / s, p);
+    }
+}
+
+TEST(correctness, div_edge_cases) {
+    big_integer a = rand_limbs(10);
+    EXPECT_EQ(a % a, 0);
+    EXPECT_EQ(a / -a, -1);
+    EXPECT_EQ(big_integer(1) << 63, big_integer::from_unsigned_long(1ULL << 63));
+    EXPECT_EQ((a << 127) >> 127, a);
+    big_integer d = big_integer::from_unsigned_long(UINT64_MAX);
+    EXPECT_EQ(d * 5 % d, 0);
+    EXPECT_EQ((d * 5 - 1) % d, d - 1);
+    EXPECT_EQ(-(d * 5 - 1) % d, 1 - d);
+    EXPECT_EQ(big_integer(INT64_MIN), -(big_integer(1) << 63));
+}
@@ -5,6 +5,8 @@ global _asm_short_sub
 global _asm_sub
 global _asm_add
 global _asm_mul
+global _asm_sqr
+global _asm_submul_1
 
 _asm_short_add:
 test rdx, rdx
@@ -131,3 +133,102 @@ pop r9
 pop rbx
 xor rax, rax
 ret
+
+;r12 - result pointer
+;r13 - first argument pointer
+;r14 - current row result pointer
+;r8 - argument length
+; [rdi] = [rsi] ^ 2, |[rsi]| = rdx, [rdi] is zeroed, |[rdi]| = 2 * rdx
+_asm_sqr:
+push rbx
+push r12
+push r13
+push r14
+mov r8, rdx ; r8 = argument length
+mov r12, rdi ; save result pointer
+mov r13, rsi ; save argument pointer
+lea r14, [rdi + 8] ; row i starts at [rdi + 8 * (2i + 1)]
+mov rcx, r8
+dec rcx ; rcx = n - 1 - i cross products in row i
+jz .double
+.row:
+mov r10, [rsi] ; r10 = a[i]
+lea r9, [rsi + 8] ; r9 = a[i + 1]
+mov rdi, r14
+mov rbx, rcx
+xor r11, r11 ; zero overflow
+.for:
+mov rax, [r9]
+mul r10 ; rdx|rax = a[i] * a[j]
+add rax, r11
+adc rdx, 0
+add rax, [rdi]
+adc rdx, 0
+mov [rdi], rax
+mov r11, rdx
+lea r9, [r9 + 8]
+lea rdi, [rdi + 8]
+dec rbx
+jnz .for
+mov [rdi], r11 ; [rdi] is untouched by the previous rows
+lea rsi, [rsi + 8]
+lea r14, [r14 + 16]
+dec rcx
+jnz .row
+.double:
+mov rdi, r12 ; cross products are doubled
+lea rcx, [r8 * 2]
+clc
+.dbl:
+mov rax, [rdi]
+adc rax, rax
+mov [rdi], rax
+lea rdi, [rdi + 8]
+dec rcx
+jnz .dbl
+mov rdi, r12 ; add a[i] ^ 2 to [rdi + 16 * i]
+mov rsi, r13
+mov rcx, r8
+xor r11, r11
+.diag:
+mov rax, [rsi]
+mul rax
+add rax, r11
+adc rdx, 0
+add [rdi], rax
+adc [rdi + 8], rdx
+mov r11, 0
+setc r11b
+lea rsi, [rsi + 8]
+lea rdi, [rdi + 16]
+dec rcx
+jnz .diag
+pop r14
+pop r13
+pop r12
+pop rbx
+xor rax, rax
+ret
+
+; [rdi] -= [rsi] * rcx, |[rdi]| = |[rsi]| = rdx
+; returns the limb to be subtracted from [rdi + 8 * rdx]
+_asm_submul_1:
+mov r8, rdx ; r8 = length
+xor r9, r9 ; zero overflow
+test r8, r8
+jz .re
+.for:
+mov rax, [rsi]
+mul rcx ; rdx|rax = [rsi] * rcx
+add rax, r9
+adc rdx, 0
+sub [rdi], rax
+adc rdx, 0 ; the borrow goes to the next limb
+mov r9, rdx
+lea rsi, [rsi + 8]
+lea rdi, [rdi + 8]
+dec r8
+jnz .for
+.re:
+mov rax, r9
+ret
@@ -0,0 +1,308 @@
+/*
+    author dzhiblavi
+ */
+
+#ifndef memory_resource_hpp
+#define memory_resource_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <memory_resource>
+
+/*
+ * resource new limb buffers of this thread are taken from, nullptr
+ * means operator new behind buffer_cache; every buffer remembers its
+ * resource and is given back to it, whatever is current by then
+ * */
+inline std::pmr::memory_resource *&_current_memory_resource() {
+    static thread_local std::pmr::memory_resource *current = nullptr;
+    return current;
+}
+
+/*
+ * per-thread cache of freed heap buffers in power-of-two buckets, it
+ * serves every buffer not taken from a memory resource; a buffer freed
+ * by another thread just lands in that thread's cache
+ * */
+class buffer_cache {
+public:
+    /* buffers kept per bucket and the largest buffer kept, in bytes */
+    static inline size_t max_buffers = 8;
+    static inline size_t max_bytes = size_t(1) << 20;
+
+    struct stats {
+        size_t hits;
+        size_t misses;
+        size_t cached_bytes;
+    };
+
+private:
+    static const size_t BUCKETS = 64;
+
+    struct node {
+        node *next;
+    };
+
+    // trivially destructible, so it stays usable while the thread exits
+    struct state {
+        node *head[BUCKETS];
+        size_t count[BUCKETS];
+        stats st;
+        bool flushed_at_exit;
+        bool exiting;
+    };
+
+    static inline thread_local state _s{};
+
+    struct flusher {
+        ~flusher() {
+            trim();
+            _s.exiting = true;
+        }
+    };
+
+    static size_t _bucket(size_t bytes) {
+        return bytes <= 1 ? 0 : 64 - __builtin_clzll(bytes - 1);
+    }
+
+public:
+    // bytes is rounded up to its bucket when the buffer may be cached
+    static void *allocate(size_t &bytes) {
+        if (bytes <= max_bytes && !_s.exiting) {
+            size_t b = _bucket(bytes);
+            bytes = size_t(1) << b;
+            if (node *n = _s.head[b]) {
+                _s.head[b] = n->next;
+                --_s.count[b];
+                _s.st.cached_bytes -= bytes;
+                ++_s.st.hits;
+                return n;
+            }
+        }
+        ++_s.st.misses;
+        return operator new(bytes);
+    }
+
+    static void deallocate(void *p, size_t bytes) {
+        if (!(bytes & (bytes - 1)) && bytes <= max_bytes && !_s.exiting) {
+            size_t b = _bucket(bytes);
+            if (_s.count[b] < max_buffers) {
+                if (!_s.flushed_at_exit) {
+                    static thread_local flusher f;
+                    (void) f;
+                    _s.flushed_at_exit = true;
+                }
+                auto *n = static_cast<node *>(p);
+                n->next = _s.head[b];
+                _s.head[b] = n;
+                ++_s.count[b];
+                _s.st.cached_bytes += bytes;
+                return;
+            }
+        }
+        operator delete(p);
+    }
+
+    // gives the buffers cached by this thread back to operator new
+    static void trim() {
+        for (size_t b = 0; b != BUCKETS; ++b) {
+            while (node *n = _s.head[b]) {
+                _s.head[b] = n->next;
+                operator delete(n);
+            }
+            _s.count[b] = 0;
+        }
+        _s.st.cached_bytes = 0;
+    }
+
+    static stats local_stats() {
+        return _s.st;
+    }
+
+    static void reset_stats() {
+        _s.st.hits = _s.st.misses = 0;
+    }
+};
+
+/*
+ * routes the limb allocations of this thread to r while alive;
+ * values allocated there must not outlive r (clone() them out)
+ * */
+class memory_scope {
+    std::pmr::memory_resource *_saved;
+
+public:
+    explicit memory_scope(std::pmr::memory_resource *r)
+            : _saved(_current_memory_resource()) {
+        _current_memory_resource() = r;
+    }
+
+    memory_scope(memory_scope const&) = delete;
+    memory_scope& operator=(memory_scope const&) = delete;
+
+    ~memory_scope() {
+        _current_memory_resource() = _saved;
+    }
+};
+
+/*
+ * bump-pointer arena: blocks grow geometrically, only the most recent
+ * allocation can be given back, everything else is returned at once
+ * by release() or the destructor; not synchronized
+ * */
+class arena_resource : public std::pmr::memory_resource {
+    struct block {
+        block *prev;
+        size_t size;
+    };
+
+    block *_head = nullptr;
+    char *_cur = nullptr;
+    char *_end = nullptr;
+    size_t _next;
+    size_t _reserved = 0;
+
+    static char *_align_up(char *p, size_t align) {
+        return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(p) + align - 1) & ~(uintptr_t) (align - 1));
+    }
+
+    void _grow(size_t need) {
+        size_t size = std::max(_next, need + sizeof(block) + alignof(std::max_align_t));
+        auto *b = static_cast<block *>(operator new(size));
+        b->prev = _head;
+        b->size = size;
+        _head = b;
+        _cur = reinterpret_cast<char *>(b + 1);
+        _end = reinterpret_cast<char *>(b) + size;
+        _reserved += size;
+        _next = size * 2;
+    }
+
+    void *do_allocate(size_t bytes, size_t align) override {
+        char *p = _align_up(_cur, align);
+        if (!_cur || p > _end || bytes > size_t(_end - p)) {
+            _grow(bytes + align);
+            p = _align_up(_cur, align);
+        }
+        _cur = p + bytes;
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t) override {
+        if (static_cast<char *>(p) + bytes == _cur) {
+            _cur = static_cast<char *>(p);
+        }
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const &rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+public:
+    explicit arena_resource(size_t initial = size_t(64) << 10)
+            : _next(initial) {}
+
+    arena_resource(arena_resource const&) = delete;
+    arena_resource& operator=(arena_resource const&) = delete;
+
+    ~arena_resource() override {
+        release();
+    }
+
+    // the next block is as large as the largest one released
+    void release() {
+        if (_head) {
+            _next = _head->size;
+        }
+        while (_head) {
+            block *prev = _head->prev;
+            operator delete(_head);
+            _head = prev;
+        }
+        _cur = _end = nullptr;
+        _reserved = 0;
+    }
+
+    // bytes taken from operator new so far
+    size_t reserved() const {
+        return _reserved;
+    }
+};
+
+/*
+ * size-class pool: requests are rounded up to a power of two and
+ * recycled through one free list per class, the largest classes
+ * go straight to operator new; not synchronized, thread_pool() is
+ * a per-thread instance whose buffers must not leave the thread
+ * */
+class pool_resource : public std::pmr::memory_resource {
+    static const size_t MIN_CLASS = 5;
+    static const size_t CLASSES = 20;
+
+    struct node {
+        node *next;
+    };
+
+    node *_free[CLASSES] = {};
+
+    static size_t _class(size_t bytes) {
+        size_t c = bytes <= (size_t(1) << MIN_CLASS) ? MIN_CLASS : 64 - __builtin_clzll(bytes - 1);
+        return c - MIN_CLASS;
+    }
+
+    void *do_allocate(size_t bytes, size_t) override {
+        size_t c = _class(bytes);
+        if (c >= CLASSES) {
+            return operator new(bytes);
+        }
+        if (node *n = _free[c]) {
+            _free[c] = n->next;
+            return n;
+        }
+        return operator new(size_t(1) << (c + MIN_CLASS));
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t) override {
+        size_t c = _class(bytes);
+        if (c >= CLASSES) {
+            operator delete(p);
+            return;
+        }
+        auto *n = static_cast<node *>(p);
+        n->next = _free[c];
+        _free[c] = n;
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const &rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+public:
+    pool_resource() = default;
+    pool_resource(pool_resource const&) = delete;
+    pool_resource& operator=(pool_resource const&) = delete;
+
+    ~pool_resource() override {
+        release();
+    }
+
+    // hands the cached buffers back to operator new
+    void release() {
+        for (node *&head : _free) {
+            while (head) {
+                node *next = head->next;
+                operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    static pool_resource &thread_pool() {
+        static thread_local pool_resource pool;
+        return pool;
+    }
+};
+
+#endif /* memory_resource_hpp */
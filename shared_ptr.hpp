@@ -5,35 +5,113 @@
 #ifndef shared_ptr_hpp
 #define shared_ptr_hpp
 
-template<typename T>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <memory_resource.hpp>
+
+/*
+ * reference count policies: plain_refcount for values that stay in one
+ * thread, atomic_refcount lets copies be made and dropped concurrently
+ * */
+struct plain_refcount {
+    size_t cnt = 1;
+
+    void acquire() {
+        ++cnt;
+    }
+
+    // true when the last reference is gone
+    bool release() {
+        return !--cnt;
+    }
+
+    size_t load() const {
+        return cnt;
+    }
+};
+
+struct atomic_refcount {
+    std::atomic<size_t> cnt{1};
+
+    void acquire() {
+        cnt.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool release() {
+        return cnt.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    size_t load() const {
+        return cnt.load(std::memory_order_acquire);
+    }
+};
+
+/*
+ * intrusive header in front of the elements, one allocation per buffer
+ * taken from resource (buffer_cache if null); capacity 0 marks foreign
+ * storage (a file mapping), its header is a foreign_handler allocated
+ * on its own and pointing at the elements
+ * */
+template <typename Refcount>
 struct pointer_handler {
-    using pointer = T*;
+    using release_fn = void (*)(void*, size_t);
+
+    Refcount cnt;
+    size_t capacity = 0;
+    std::pmr::memory_resource *resource = nullptr;
+    size_t bytes = 0;
+};
 
-    pointer _ptr = nullptr;
-    size_t cnt = 0;
+template <typename Refcount>
+struct foreign_handler : pointer_handler<Refcount> {
+    using release_fn = typename pointer_handler<Refcount>::release_fn;
+
+    void *_ptr = nullptr;
+    release_fn _release = nullptr;
+    void *_base = nullptr;
+    size_t _len = 0;
 };
 
-template <typename T>
+template <typename T, typename Refcount = plain_refcount>
 class shared_ptr {
     using value_type = T;
     using pointer = T *;
+    using pointer_handler = ::pointer_handler<Refcount>;
+    using foreign_handler = ::foreign_handler<Refcount>;
+
+    // the elements start right after the header, aligned as new aligns
+    static const size_t HEADER_SIZE = (sizeof(pointer_handler) + alignof(std::max_align_t) - 1)
+                                      / alignof(std::max_align_t) * alignof(std::max_align_t);
 
-    pointer_handler<T> *_handler = nullptr;
+    pointer_handler *_handler = nullptr;
 
     void _destruct_handler() {
-        if (_handler && !--_handler->cnt) {
-            operator delete(_handler->_ptr);
-            delete _handler;
+        if (_handler && _handler->cnt.release()) {
+            if (_handler->capacity) {
+                if (std::pmr::memory_resource *r = _handler->resource) {
+                    r->deallocate(_handler, _handler->bytes, alignof(std::max_align_t));
+                } else {
+                    buffer_cache::deallocate(_handler, _handler->bytes);
+                }
+            } else {
+                auto *fh = static_cast<foreign_handler *>(_handler);
+                fh->_release(fh->_base, fh->_len);
+                delete fh;
+            }
         }
     }
 
 public:
+    using release_fn = typename pointer_handler::release_fn;
+
     shared_ptr() = default;
 
     shared_ptr(shared_ptr const& rhs) {
         if (rhs._handler) {
             _handler = rhs._handler;
-            ++_handler->cnt;
+            _handler->cnt.acquire();
         }
     }
 
@@ -41,10 +119,30 @@ public:
         swap(rhs);
     }
 
-    shared_ptr(pointer _n_ptr) {
-        _handler = new pointer_handler<T>;
-        _handler->_ptr = _n_ptr;
-        _handler->cnt = 1;
+    /*
+     * uninitialized room for at least capacity > 0 elements behind a fresh
+     * header, from the current memory resource of the thread or the buffer
+     * cache; the slack of a rounded up cache bucket is part of capacity()
+     * */
+    static shared_ptr allocate(size_t capacity) {
+        size_t bytes = HEADER_SIZE + capacity * sizeof(T);
+        std::pmr::memory_resource *r = _current_memory_resource();
+        shared_ptr ret;
+        ret._handler = new(r ? r->allocate(bytes, alignof(std::max_align_t)) : buffer_cache::allocate(bytes))
+                pointer_handler;
+        ret._handler->capacity = (bytes - HEADER_SIZE) / sizeof(T);
+        ret._handler->resource = r;
+        ret._handler->bytes = bytes;
+        return ret;
+    }
+
+    shared_ptr(pointer _n_ptr, release_fn _release, void *_base, size_t _len) {
+        auto *fh = new foreign_handler;
+        fh->_ptr = _n_ptr;
+        fh->_release = _release;
+        fh->_base = _base;
+        fh->_len = _len;
+        _handler = fh;
     }
 
     ~shared_ptr() {
@@ -57,7 +155,7 @@ public:
         _destruct_handler();
         _handler = rhs._handler;
         if (rhs._handler)
-            ++_handler->cnt;
+            _handler->cnt.acquire();
         return *this;
     }
 
@@ -74,20 +172,31 @@ public:
         shared_ptr().swap(*this);
     }
 
-    void reset(pointer _n_ptr) {
-        shared_ptr(_n_ptr).swap(*this);
+    bool unique() const {
+        return !_handler || _handler->cnt.load() == 1;
     }
 
-    bool unique() const {
-        return !_handler || _handler->cnt == 1;
+    bool foreign() const {
+        return _handler && !_handler->capacity;
+    }
+
+    // elements the buffer has room for, 0 for foreign storage
+    size_t capacity() const {
+        return _handler ? _handler->capacity : 0;
     }
 
     size_t use_count() const {
-        return _handler ? _handler->cnt : 1;
+        return _handler ? _handler->cnt.load() : 1;
     }
 
     pointer get() const {
-        return _handler ? _handler->_ptr : nullptr;
+        if (!_handler) {
+            return nullptr;
+        }
+        if (!_handler->capacity) {
+            return static_cast<pointer>(static_cast<foreign_handler *>(_handler)->_ptr);
+        }
+        return reinterpret_cast<pointer>(reinterpret_cast<char *>(_handler) + HEADER_SIZE);
     }
 };
 
@@ -12,18 +12,18 @@
 #include <algorithm>
 #include <shared_ptr.hpp>
 
-template<typename T>
-T* _allocate_new_zone(T const* __restrict__ _src, size_t size, size_t alloc) {
-    auto _allocdata_ = static_cast<T *> (operator new(alloc * sizeof(T)));
-    std::copy(_src, _src + size, _allocdata_);
-    return _allocdata_;
+template<typename T, typename Refcount>
+shared_ptr<T, Refcount> _allocate_new_zone(T const* __restrict__ _src, size_t size, size_t alloc) {
+    auto _zone_ = shared_ptr<T, Refcount>::allocate(alloc);
+    std::uninitialized_copy(_src, _src + size, _zone_.get());
+    return _zone_;
 }
 
 /*
  * small object
- * copy-on-write
+ * copy-on-write, Refcount is plain_refcount or atomic_refcount
  * */
-template<typename T, size_t INIT_SO_SIZE_ = 6>
+template<typename T, size_t INIT_SO_SIZE_ = 6, typename Refcount = plain_refcount>
 class vector {
 public:
     using value_type = T;
@@ -31,7 +31,7 @@ public:
     using const_reference = T const &;
     using pointer = T *;
     using const_pointer = T const *;
-    using shared_pointer = shared_ptr<T>;
+    using shared_pointer = shared_ptr<T, Refcount>;
 
 private:
     T small_[INIT_SO_SIZE_];
@@ -41,10 +41,15 @@ private:
     size_t size_ = 0;
     size_t capacity_ = INIT_SO_SIZE_;
 
-    void _set_unique_large_data_(pointer __restrict__ allocated_, size_t new_capacity_) {
-        shp_.reset(allocated_);
-        data_ = allocated_;
-        capacity_ = new_capacity_;
+    void _set_unique_large_data_(shared_pointer zone_) {
+        shp_.swap(zone_);
+        data_ = shp_.get();
+        capacity_ = shp_.capacity();
+    }
+
+    // a buffer this vector alone may write to
+    bool _writable_() const {
+        return shp_.unique() && !shp_.foreign();
     }
 
     void _set_unique_small_data_() {
@@ -58,17 +63,16 @@ private:
     }
 
     void _push_back_long_path(const_reference x) {
-        size_t new_capacity_ = capacity_ << 1;
-        pointer alloc_data_ = _allocate_new_zone(data_, size_, new_capacity_);
+        size_t new_capacity_ = size_ < capacity_ ? capacity_ : capacity_ << 1;
+        shared_pointer zone_ = _allocate_new_zone<T, Refcount>(data_, size_, new_capacity_);
         try {
-            new(alloc_data_ + size_) T(x);
+            new(zone_.get() + size_) T(x);
         } catch (...) {
-            std::destroy(alloc_data_, alloc_data_ + size_);
-            operator delete(alloc_data_);
+            std::destroy(zone_.get(), zone_.get() + size_);
             throw;
         }
         std::destroy(data_, data_ + size_);
-        _set_unique_large_data_(alloc_data_, new_capacity_);
+        _set_unique_large_data_(std::move(zone_));
     }
 
     void _resize_short_path(size_t new_size_) {
@@ -79,17 +83,26 @@ private:
         }
     }
 
+    // grows at least geometrically, so a run of small resizes is amortized
     void _resize_long_path(size_t new_size_) {
-        pointer alloc_data_ = _allocate_new_zone(data_, size_, new_size_);
+        size_t new_capacity_ = new_size_ <= capacity_ ? capacity_ : std::max(new_size_, capacity_ << 1);
+        shared_pointer zone_ = _allocate_new_zone<T, Refcount>(data_, size_, new_capacity_);
         try {
-            std::uninitialized_fill(alloc_data_ + size_, alloc_data_ + new_size_, T());
+            std::uninitialized_fill(zone_.get() + size_, zone_.get() + new_size_, T());
         } catch (...) {
-            std::destroy(alloc_data_, alloc_data_ + size_);
-            operator delete(alloc_data_);
+            std::destroy(zone_.get(), zone_.get() + size_);
             throw;
         }
         std::destroy(data_, data_ + size_);
-        _set_unique_large_data_(alloc_data_, new_size_);
+        _set_unique_large_data_(std::move(zone_));
+    }
+
+    void _reallocate(size_t new_capacity_) {
+        shared_pointer zone_ = _allocate_new_zone<T, Refcount>(data_, size_, new_capacity_);
+        if (shp_.unique()) {
+            std::destroy(data_, data_ + size_);
+        }
+        _set_unique_large_data_(std::move(zone_));
     }
 
 public:
@@ -100,17 +113,30 @@ public:
         if (initial_size_ <= INIT_SO_SIZE_) {
             std::uninitialized_fill(data_, data_ + initial_size_, T());
         } else {
-            auto alloc_data_ = static_cast<pointer> (operator new(initial_size_ * sizeof(T)));
-            try {
-                std::uninitialized_fill(alloc_data_, alloc_data_ + initial_size_, T());
-            } catch (...) {
-                operator delete (alloc_data_);
-            }
-            _set_unique_large_data_(alloc_data_, initial_size_);
+            shared_pointer zone_ = shared_pointer::allocate(initial_size_);
+            std::uninitialized_fill(zone_.get(), zone_.get() + initial_size_, T());
+            _set_unique_large_data_(std::move(zone_));
         }
         size_ = initial_size_;
     }
 
+    /*
+     * adopts n elements of read-only foreign storage, released through
+     * release(base, len) with the last copy; detach() always copies it
+     * and the capacity is n, so it is never written in place
+     * */
+    vector(pointer p, size_t n, typename shared_pointer::release_fn release, void *base, size_t len) {
+        if (n <= INIT_SO_SIZE_) {
+            std::uninitialized_copy(p, p + n, small_);
+            release(base, len);
+        } else {
+            shp_ = shared_pointer(p, release, base, len);
+            data_ = p;
+            capacity_ = n;
+        }
+        size_ = n;
+    }
+
     ~vector() noexcept {
         std::destroy(data_, data_ + size_);
     }
@@ -182,13 +208,42 @@ public:
     }
 
     void detach() {
-        if (!shp_.unique()) {
-            _set_unique_large_data_(_allocate_new_zone(data_, size_, capacity_), capacity_);
+        if (!_writable_()) {
+            _set_unique_large_data_(_allocate_new_zone<T, Refcount>(data_, size_, capacity_));
+        }
+    }
+
+    /*
+     * room for n elements without reallocation; a buffer that has to
+     * grow is replaced by a unique one, so copies are not affected
+     * */
+    void reserve(size_t n) {
+        if (n > capacity_) {
+            _reallocate(n);
+        }
+    }
+
+    /*
+     * drops the unused capacity: back to the small buffer if the elements
+     * fit, one sized for them otherwise (up to the rounding of the buffer
+     * cache); a shared buffer is left alone, a copy would only add memory
+     * */
+    void shrink_to_fit() {
+        if (small() || !_writable_()) {
+            return;
+        }
+        if (size_ <= INIT_SO_SIZE_) {
+            std::uninitialized_copy(data_, data_ + size_, small_);
+            std::destroy(data_, data_ + size_);
+            _set_unique_small_data_();
+        } else if (size_ < capacity_) {
+            _reallocate(size_);
         }
     }
 
+    // spare capacity of a shared buffer is not written, it gets a unique one
     void push_back(const_reference x) {
-        if (size_ < capacity_) {
+        if (size_ < capacity_ && _writable_()) {
             _push_back_short_path(x);
         } else {
             _push_back_long_path(x);
@@ -202,7 +257,7 @@ public:
     }
 
     void resize(size_t newsize_) {
-        if (newsize_ <= capacity_) {
+        if (newsize_ <= capacity_ && (newsize_ <= size_ || _writable_())) {
             _resize_short_path(newsize_);
         } else {
             _resize_long_path(newsize_);